@@ -1,5 +1,6 @@
 #include <iostream>
 #include "dungeonerator.hpp"
+#include "dungeonExport.hpp"
 
 // #include <SDL3/SDL.h>
 // #include <glm/glm.hpp>
@@ -28,27 +29,7 @@ int main() {
     DungeonGenerator::GenerationData generationData(75000, 0, 1.0, {1.0f, 1.0f}, {100.0f, 100.0f}, false, true, 0.3f);
     DungeonGenerator::Dungeon myDungeon(generationData);
 
-    //     std::cout << "Vertices: " << std::endl;
-    //     for (size_t i = 0; i < myDungeon.mVertices.size(); i++) {
-    //         auto& vertex = myDungeon.mVertices[i];
-    //
-    //         std::cout << "Vertex " << i << " at: " << vertex.mPx << ", " << vertex.mPy << " size of: " << vertex.mSize << std::endl;
-    //
-    //         std::cout << "Edges: ";
-    //         for (auto& edge : vertex.mConnections) {
-    //             std::cout << edge << ", ";
-    //         }
-    //
-    //         std::cout << std::endl;
-    //     }
-    //
-    //     std::cout << "Edges: " << std::endl;
-    //
-    //     for (size_t i = 0; i < myDungeon.mEdges.size(); i++) {
-    //         auto& edge = myDungeon.mEdges[i];
-    //         std::cout << i << ": " << edge.mNode1 << ", " << edge.mNode2 << std::endl;
-    //     }
-    // }
+    // DungeonGenerator::ExportDungeon(myDungeon, DungeonGenerator::ExportFormat::JSON, "dungeon.json");
 
     return 0;
 }
@@ -150,7 +131,7 @@ int main() {
     //         std::cout << vertex.first << ": data: " << vertex.second._data.a << std::endl;
     //         std::cout << "edges: " << std::endl;
     //
-    //         for (EdgeId edge : vertex.second._edges) {
+    //         for (EdgeId edge : myGraph.IncidentEdges(vertex.first)) {
     //             std::cout << edge << std::endl;
     //         }
     //     }
@@ -167,9 +148,9 @@ int main() {
     //     }
     // }
     //
-    // myGraph.RemoveEdge(0, 1);
+    // myGraph.RemoveEdge(a, b);
     //
-    // myGraph.RemoveVertex(2);
+    // myGraph.RemoveVertex(c);
     //
     //
     // {
@@ -182,7 +163,7 @@ int main() {
     //         std::cout << vertex.first << ": data: " << vertex.second._data.a << std::endl;
     //         std::cout << "edges: " << std::endl;
     //
-    //         for (EdgeId edge : vertex.second._edges) {
+    //         for (EdgeId edge : myGraph.IncidentEdges(vertex.first)) {
     //             std::cout << edge << std::endl;
     //         }
     //     }
@@ -241,7 +222,7 @@ int main() {
 //         if (applyGrammar) {
 //             formalGrammar.PrintInfo();
 //
-//             std::list<SymbolRegistry::SymbolID> startString = {reg.GetSymbol("S")};
+//             std::vector<SymbolRegistry::SymbolID> startString = {reg.GetSymbol("S")};
 //             formalGrammar.ExecuteGrammar(startString);
 //
 //             std::cout << "Grammar output: ";
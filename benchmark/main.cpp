@@ -0,0 +1,560 @@
+// Performance regression tracker for the dungeon generator.
+//
+// Usage:
+//   benchmark record <baseline.json> [--repetitions N]
+//   benchmark compare <baseline.json> [--repetitions N] [--threshold 0.10] [--sigma 3]
+//
+// Runs a fixed matrix of generation configurations, timing every pipeline stage.
+// Compare exits with 1 when a stage regressed or the output checksum changed, and prints a diff table.
+// Against a baseline of another library version the output is expected to change, checksums are only reported then.
+
+#include "dungeonerator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using DungeonGenerator::GenerationData;
+using DungeonGenerator::GenerationStage;
+
+constexpr int FORMAT_VERSION = 2;
+constexpr auto STAGE_COUNT = static_cast<std::size_t>(GenerationStage::NUM_STAGES);
+
+struct BenchmarkConfig {
+    const char* name;
+    GenerationData data;
+};
+
+// Changing this matrix invalidates existing baselines
+const std::vector<BenchmarkConfig>& ConfigMatrix() {
+    static const std::vector<BenchmarkConfig> configs = {
+        {"small_circle", GenerationData(1000, 10, 1, {1.0f, 3.0f}, {100.0f, 100.0f}, true, true, 0.3f)},
+        {"medium_rect", GenerationData(10000, 100, 2, {1.0f, 3.0f}, {500.0f, 500.0f}, false, true, 0.3f)},
+        {"medium_loops", GenerationData(10000, 5000, 3, {1.0f, 1.0f}, {500.0f, 500.0f}, false, false, 0.3f)},
+        {"large_rect", GenerationData(50000, 500, 4, {1.0f, 3.0f}, {1000.0f, 1000.0f}, false, true, 0.3f)},
+    };
+    return configs;
+}
+
+struct Statistics {
+    double median = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    int samples = 0;
+};
+
+Statistics Summarize(std::vector<double> values) {
+    Statistics stats;
+    stats.samples = static_cast<int>(values.size());
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+    const std::size_t mid = values.size() / 2;
+    stats.median = values.size() % 2 == 1 ? values[mid] : (values[mid - 1] + values[mid]) * 0.5;
+
+    for (double value : values) {
+        stats.mean += value;
+    }
+    stats.mean /= static_cast<double>(values.size());
+
+    if (values.size() > 1) {
+        double variance = 0.0;
+        for (double value : values) {
+            variance += (value - stats.mean) * (value - stats.mean);
+        }
+        stats.stddev = std::sqrt(variance / static_cast<double>(values.size() - 1));
+    }
+    return stats;
+}
+
+// Stores the output in flat arrays and records how long each stage took
+class TimingSink {
+public:
+    void SetVertexCount(std::uint32_t count) {
+        mPositions.resize(count * 2ull);
+        mSizes.resize(count);
+        mTypes.resize(count);
+        mDifficulty.resize(count);
+        mEdges.clear();
+    }
+
+    void SetVertex(std::uint32_t index, float x, float y, float size) {
+        mPositions[index * 2ull] = x;
+        mPositions[index * 2ull + 1] = y;
+        mSizes[index] = size;
+    }
+
+    void SetType(std::uint32_t index, DungeonGenerator::RoomType type) { mTypes[index] = type; }
+
+    void SetDifficulty(std::uint32_t index, float difficulty) { mDifficulty[index] = difficulty; }
+
+    void AddEdge(std::uint32_t a, std::uint32_t b) { mEdges.emplace_back(a, b); }
+
+    void StageCompleted(GenerationStage stage) {
+        const auto now = Clock::now();
+        mStageSeconds[static_cast<std::size_t>(stage)] = std::chrono::duration<double>(now - mLast).count();
+        mLast = now;
+    }
+
+    void Start() {
+        mStageSeconds.fill(0.0);
+        mLast = Clock::now();
+    }
+
+    [[nodiscard]] std::uint64_t Checksum() const {
+        std::uint64_t hash = 14695981039346656037ull;
+        const auto mix = [&](const void* data, std::size_t size) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        mix(mPositions.data(), mPositions.size() * sizeof(float));
+        mix(mSizes.data(), mSizes.size() * sizeof(float));
+        mix(mTypes.data(), mTypes.size() * sizeof(DungeonGenerator::RoomType));
+        mix(mDifficulty.data(), mDifficulty.size() * sizeof(float));
+        mix(mEdges.data(), mEdges.size() * sizeof(DungeonGenerator::DungeonEdge));
+        return hash;
+    }
+
+    std::array<double, STAGE_COUNT> mStageSeconds{};
+    std::vector<float> mPositions{};
+    std::vector<float> mSizes{};
+    std::vector<DungeonGenerator::RoomType> mTypes{};
+    std::vector<float> mDifficulty{};
+    std::vector<DungeonGenerator::DungeonEdge> mEdges{};
+
+private:
+    Clock::time_point mLast{};
+};
+
+struct ConfigResult {
+    std::string name;
+    std::string checksum;
+    std::size_t vertices = 0;
+    std::size_t edges = 0;
+    std::array<Statistics, STAGE_COUNT> stages{};
+    Statistics total{};
+};
+
+std::string ToHex(std::uint64_t value) {
+    char buffer[17]{};
+    std::to_chars(buffer, buffer + 16, value, 16);
+    return buffer;
+}
+
+std::vector<ConfigResult> RunMatrix(int repetitions) {
+    std::vector<ConfigResult> results;
+
+    for (const auto& config : ConfigMatrix()) {
+        std::cout << "Running " << config.name << " " << std::flush;
+
+        ConfigResult result;
+        result.name = config.name;
+
+        std::array<std::vector<double>, STAGE_COUNT> stageSamples{};
+        std::vector<double> totalSamples;
+        TimingSink sink;
+
+        for (int i = 0; i < repetitions; i++) {
+            sink.Start();
+            const auto start = Clock::now();
+            const auto generated = DungeonGenerator::GenerateInto(config.data, sink);
+            totalSamples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+
+            for (std::size_t stage = 0; stage < STAGE_COUNT; stage++) {
+                stageSamples[stage].push_back(sink.mStageSeconds[stage]);
+            }
+
+            const std::string checksum = ToHex(sink.Checksum());
+            if (!result.checksum.empty() && checksum != result.checksum) {
+                std::cout << "(non deterministic output) ";
+            }
+            result.checksum = checksum;
+            result.vertices = generated.mVertexCount;
+            result.edges = generated.mEdgeCount;
+            std::cout << "." << std::flush;
+        }
+
+        for (std::size_t stage = 0; stage < STAGE_COUNT; stage++) {
+            result.stages[stage] = Summarize(stageSamples[stage]);
+        }
+        result.total = Summarize(totalSamples);
+
+        std::cout << " " << result.total.median * 1000.0 << " ms\n";
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+void WriteStatistics(std::ostream& out, const Statistics& stats) {
+    out << "{\"median\": " << stats.median << ", \"mean\": " << stats.mean
+        << ", \"stddev\": " << stats.stddev << ", \"samples\": " << stats.samples << "}";
+}
+
+void WriteBaseline(std::ostream& out, const std::vector<ConfigResult>& results) {
+    out.precision(9);
+    out << "{\n  \"format\": " << FORMAT_VERSION << ",\n  \"library_version\": " << DungeonGenerator::LIBRARY_VERSION
+        << ",\n  \"configs\": [\n";
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        out << "    {\n      \"name\": \"" << result.name << "\",\n      \"checksum\": \"" << result.checksum
+            << "\",\n      \"vertices\": " << result.vertices << ",\n      \"edges\": " << result.edges
+            << ",\n      \"total\": ";
+        WriteStatistics(out, result.total);
+        out << ",\n      \"stages\": {\n";
+        for (std::size_t stage = 0; stage < STAGE_COUNT; stage++) {
+            out << "        \"" << DungeonGenerator::StageName(static_cast<GenerationStage>(stage)) << "\": ";
+            WriteStatistics(out, result.stages[stage]);
+            out << (stage + 1 < STAGE_COUNT ? ",\n" : "\n");
+        }
+        out << "      }\n    }" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+}
+
+// Minimal JSON reader, enough for the baseline files written above
+struct JsonValue {
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = Type::NUL;
+    double number = 0.0;
+    std::string string{};
+    std::vector<JsonValue> array{};
+    std::vector<std::pair<std::string, JsonValue>> object{};
+
+    [[nodiscard]] const JsonValue* Find(const std::string& key) const {
+        for (const auto& [name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] double Number(const std::string& key) const {
+        const JsonValue* value = Find(key);
+        return value && value->type == Type::NUMBER ? value->number : 0.0;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(std::string_view text) : mText(text) {}
+
+    JsonValue Parse() {
+        JsonValue value = ParseValue();
+        SkipWhitespace();
+        if (mPos != mText.size()) {
+            throw std::runtime_error("Trailing characters in JSON");
+        }
+        return value;
+    }
+
+private:
+    void SkipWhitespace() {
+        while (mPos < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPos]))) {
+            ++mPos;
+        }
+    }
+
+    void Expect(char c) {
+        SkipWhitespace();
+        if (mPos >= mText.size() || mText[mPos] != c) {
+            throw std::runtime_error(std::string("Expected '") + c + "' in JSON");
+        }
+        ++mPos;
+    }
+
+    std::string ParseString() {
+        Expect('"');
+        std::string result;
+        while (mPos < mText.size() && mText[mPos] != '"') {
+            if (mText[mPos] == '\\' && mPos + 1 < mText.size()) {
+                ++mPos;
+            }
+            result.push_back(mText[mPos++]);
+        }
+        Expect('"');
+        return result;
+    }
+
+    JsonValue ParseValue() {
+        SkipWhitespace();
+        if (mPos >= mText.size()) {
+            throw std::runtime_error("Unexpected end of JSON");
+        }
+
+        JsonValue value;
+        const char c = mText[mPos];
+
+        if (c == '{') {
+            value.type = JsonValue::Type::OBJECT;
+            ++mPos;
+            SkipWhitespace();
+            if (mPos < mText.size() && mText[mPos] == '}') {
+                ++mPos;
+                return value;
+            }
+            do {
+                std::string key = ParseString();
+                Expect(':');
+                value.object.emplace_back(std::move(key), ParseValue());
+                SkipWhitespace();
+            } while (mPos < mText.size() && mText[mPos] == ',' && ++mPos);
+            Expect('}');
+        } else if (c == '[') {
+            value.type = JsonValue::Type::ARRAY;
+            ++mPos;
+            SkipWhitespace();
+            if (mPos < mText.size() && mText[mPos] == ']') {
+                ++mPos;
+                return value;
+            }
+            do {
+                value.array.push_back(ParseValue());
+                SkipWhitespace();
+            } while (mPos < mText.size() && mText[mPos] == ',' && ++mPos);
+            Expect(']');
+        } else if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            value.string = ParseString();
+        } else if (mText.substr(mPos, 4) == "true" || mText.substr(mPos, 5) == "false") {
+            value.type = JsonValue::Type::BOOL;
+            value.number = c == 't' ? 1.0 : 0.0;
+            mPos += c == 't' ? 4 : 5;
+        } else if (mText.substr(mPos, 4) == "null") {
+            mPos += 4;
+        } else {
+            value.type = JsonValue::Type::NUMBER;
+            const auto [end, error] = std::from_chars(mText.data() + mPos, mText.data() + mText.size(), value.number);
+            if (error != std::errc()) {
+                throw std::runtime_error("Invalid number in JSON");
+            }
+            mPos = static_cast<std::size_t>(end - mText.data());
+        }
+
+        return value;
+    }
+
+    std::string_view mText;
+    std::size_t mPos = 0;
+};
+
+Statistics ReadStatistics(const JsonValue* value) {
+    Statistics stats;
+    if (value) {
+        stats.median = value->Number("median");
+        stats.mean = value->Number("mean");
+        stats.stddev = value->Number("stddev");
+        stats.samples = static_cast<int>(value->Number("samples"));
+    }
+    return stats;
+}
+
+struct Baseline {
+    std::uint32_t libraryVersion = 0;
+    std::vector<ConfigResult> configs{};
+};
+
+Baseline ReadBaseline(const JsonValue& root) {
+    if (root.Number("format") != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported baseline format");
+    }
+
+    Baseline baseline;
+    baseline.libraryVersion = static_cast<std::uint32_t>(root.Number("library_version"));
+    auto& results = baseline.configs;
+    const JsonValue* configs = root.Find("configs");
+    if (!configs) {
+        return baseline;
+    }
+
+    for (const auto& config : configs->array) {
+        ConfigResult result;
+        if (const JsonValue* name = config.Find("name")) {
+            result.name = name->string;
+        }
+        if (const JsonValue* checksum = config.Find("checksum")) {
+            result.checksum = checksum->string;
+        }
+        result.vertices = static_cast<std::size_t>(config.Number("vertices"));
+        result.edges = static_cast<std::size_t>(config.Number("edges"));
+        result.total = ReadStatistics(config.Find("total"));
+
+        if (const JsonValue* stages = config.Find("stages")) {
+            for (std::size_t stage = 0; stage < STAGE_COUNT; stage++) {
+                result.stages[stage] = ReadStatistics(stages->Find(DungeonGenerator::StageName(static_cast<GenerationStage>(stage))));
+            }
+        }
+        results.push_back(std::move(result));
+    }
+    return baseline;
+}
+
+struct Thresholds {
+    double relative = 0.10; // Slowdown ratio that counts as a regression
+    double sigma = 3.0; // The slowdown must also exceed this many combined standard deviations
+    double absolute = 0.0005; // Seconds, ignore noise on stages that barely take any time
+};
+
+bool IsRegression(const Statistics& baseline, const Statistics& current, const Thresholds& thresholds) {
+    const double delta = current.median - baseline.median;
+    const double noise = std::sqrt(baseline.stddev * baseline.stddev + current.stddev * current.stddev);
+
+    return delta > thresholds.absolute
+        && delta > baseline.median * thresholds.relative
+        && delta > thresholds.sigma * noise;
+}
+
+void PrintRow(const std::string& config, const std::string& stage, double baseline, double current, const char* status) {
+    char line[160];
+    const double change = baseline > 0.0 ? (current - baseline) / baseline * 100.0 : 0.0;
+    std::snprintf(line, sizeof(line), "%-14s %-14s %12.3f %12.3f %+9.1f%%  %s\n",
+        config.c_str(), stage.c_str(), baseline * 1000.0, current * 1000.0, change, status);
+    std::cout << line;
+}
+
+int Compare(const Baseline& baseline, const std::vector<ConfigResult>& current, const Thresholds& thresholds) {
+    int failures = 0;
+
+    const bool sameLibrary = baseline.libraryVersion == DungeonGenerator::LIBRARY_VERSION;
+    if (!sameLibrary) {
+        std::cout << "Baseline is from library version " << baseline.libraryVersion << ", now " << DungeonGenerator::LIBRARY_VERSION
+            << ": output changes are expected and not counted\n";
+    }
+
+    char header[160];
+    std::snprintf(header, sizeof(header), "%-14s %-14s %12s %12s %10s  %s\n", "config", "stage", "base ms", "now ms", "change", "status");
+    std::cout << "\n" << header;
+
+    for (const auto& result : current) {
+        const auto it = std::find_if(baseline.configs.begin(), baseline.configs.end(), [&](const ConfigResult& base) { return base.name == result.name; });
+        if (it == baseline.configs.end()) {
+            std::cout << result.name << ": not in baseline, skipped\n";
+            continue;
+        }
+
+        for (std::size_t stage = 0; stage < STAGE_COUNT; stage++) {
+            const bool regressed = IsRegression(it->stages[stage], result.stages[stage], thresholds);
+            failures += regressed;
+            PrintRow(result.name, DungeonGenerator::StageName(static_cast<GenerationStage>(stage)),
+                it->stages[stage].median, result.stages[stage].median, regressed ? "REGRESSED" : "ok");
+        }
+
+        const bool totalRegressed = IsRegression(it->total, result.total, thresholds);
+        failures += totalRegressed;
+        PrintRow(result.name, "total", it->total.median, result.total.median, totalRegressed ? "REGRESSED" : "ok");
+
+        if (it->checksum != result.checksum) {
+            failures += sameLibrary;
+            std::cout << result.name << ": output changed, checksum " << it->checksum << " -> " << result.checksum
+                << " (" << it->vertices << " -> " << result.vertices << " vertices, "
+                << it->edges << " -> " << result.edges << " edges)\n";
+        }
+    }
+
+    std::cout << "\n" << (failures == 0 ? "No regressions" : std::to_string(failures) + " regression(s)") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// The whole argument has to be a number, anything else leaves value untouched
+template <typename T>
+bool ParseOption(std::string_view argument, T& value) {
+    T parsed{};
+    const auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), parsed);
+    if (error != std::errc() || end != argument.data() + argument.size()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+int PrintUsage() {
+    std::cout << "Usage:\n"
+              << "  benchmark record <baseline.json> [--repetitions N]\n"
+              << "  benchmark compare <baseline.json> [--repetitions N] [--threshold 0.10] [--sigma 3]\n";
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return PrintUsage();
+    }
+
+    const std::string mode = argv[1];
+    const std::string path = argv[2];
+    int repetitions = 5;
+    Thresholds thresholds;
+
+    for (int i = 3; i < argc; i += 2) {
+        const std::string option = argv[i];
+        if (i + 1 == argc) {
+            return PrintUsage(); // An option without its value
+        }
+        bool valid = false;
+        if (option == "--repetitions") {
+            valid = ParseOption(argv[i + 1], repetitions) && repetitions > 0;
+        } else if (option == "--threshold") {
+            valid = ParseOption(argv[i + 1], thresholds.relative) && thresholds.relative >= 0.0;
+        } else if (option == "--sigma") {
+            valid = ParseOption(argv[i + 1], thresholds.sigma) && thresholds.sigma >= 0.0;
+        }
+        if (!valid) {
+            return PrintUsage();
+        }
+    }
+
+    if (mode == "record") {
+        const auto results = RunMatrix(repetitions);
+        std::ofstream file(path);
+        if (!file) {
+            std::cout << "Could not write baseline " << path << std::endl;
+            return 2;
+        }
+        WriteBaseline(file, results);
+        std::cout << "Baseline written to " << path << std::endl;
+        return 0;
+    }
+
+    if (mode == "compare") {
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "Could not read baseline " << path << std::endl;
+            return 2;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+
+        Baseline baseline;
+        try {
+            baseline = ReadBaseline(JsonParser(text.str()).Parse());
+        } catch (const std::exception& e) {
+            std::cout << "Invalid baseline " << path << ": " << e.what() << std::endl;
+            return 2;
+        }
+
+        return Compare(baseline, RunMatrix(repetitions), thresholds);
+    }
+
+    return PrintUsage();
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <span>
+
+namespace DungeonGenerator
+{
+
+// Memory lean copy of a dungeon.
+// Room data is stored as packed arrays and connectivity only as the edge list with IndexType indices,
+// the per room adjacency is derived from the edges on first use and can be released again.
+// Use uint16_t as IndexType for dungeons with fewer than 65536 rooms.
+template <typename IndexType = std::uint32_t>
+class BasicCompactDungeon
+{
+public:
+    static_assert(std::is_unsigned_v<IndexType> && sizeof(IndexType) <= sizeof(std::uint32_t));
+
+    struct Position
+    {
+        float mPx{};
+        float mPy{};
+    };
+
+    struct Edge
+    {
+        IndexType mNode1{};
+        IndexType mNode2{};
+    };
+
+    BasicCompactDungeon() = default;
+
+    // Generates straight into the packed arrays, no Dungeon is built on the way
+    explicit BasicCompactDungeon(const GenerationData& generationData)
+        : mGenerationData(generationData)
+    {
+        PackedSink sink{ *this };
+        GenerateInto(mGenerationData, sink);
+    }
+
+    explicit BasicCompactDungeon(const Dungeon& dungeon)
+        : mGenerationData(dungeon.mGenerationData)
+    {
+        if (dungeon.mVertices.size() > static_cast<std::size_t>(std::numeric_limits<IndexType>::max())) {
+            throw std::length_error("Dungeon has too many rooms for the compact index type");
+        }
+
+        mPositions.reserve(dungeon.mVertices.size());
+        mSizes.reserve(dungeon.mVertices.size());
+        mTypes.reserve(dungeon.mVertices.size());
+
+        for (const auto& vertex : dungeon.mVertices) {
+            mPositions.push_back({vertex.mPx, vertex.mPy});
+            mSizes.push_back(vertex.mSize);
+            mTypes.push_back(vertex.mType);
+        }
+
+        // Always 0 without gameplay content, not worth storing then
+        if (mGenerationData.mGenerateGameplayContent) {
+            mDifficulty.reserve(dungeon.mVertices.size());
+            for (const auto& vertex : dungeon.mVertices) {
+                mDifficulty.push_back(vertex.mDifficulty);
+            }
+        }
+
+        mEdges.reserve(dungeon.mEdges.size());
+        for (const auto& edge : dungeon.mEdges) {
+            mEdges.push_back({static_cast<IndexType>(edge.mNode1), static_cast<IndexType>(edge.mNode2)});
+        }
+
+        // Already flat arrays, kept as they are
+        mNavMesh = dungeon.mNavMesh;
+        mPathHierarchy = dungeon.mPathHierarchy;
+        mMetrics = dungeon.mMetrics;
+    }
+
+    [[nodiscard]] std::size_t RoomCount() const { return mPositions.size(); }
+
+    [[nodiscard]] std::span<const Position> Positions() const { return mPositions; }
+    [[nodiscard]] std::span<const float> Sizes() const { return mSizes; }
+    [[nodiscard]] std::span<const RoomType> Types() const { return mTypes; }
+    [[nodiscard]] std::span<const float> Difficulty() const { return mDifficulty; } // Empty without gameplay content
+    [[nodiscard]] std::span<const Edge> Edges() const { return mEdges; }
+    [[nodiscard]] const NavMesh& GetNavMesh() const { return mNavMesh; } // Empty unless it was built
+    [[nodiscard]] const PathHierarchy& GetPathHierarchy() const { return mPathHierarchy; } // Empty unless it was built
+    [[nodiscard]] const DungeonMetrics& GetMetrics() const { return mMetrics; } // Empty unless they were computed
+
+    // Builds the adjacency on the first call, call BuildAdjacency() up front before sharing between threads
+    [[nodiscard]] std::span<const IndexType> Neighbours(std::size_t room) const
+    {
+        BuildAdjacency();
+        return std::span<const IndexType>(mNeighbours).subspan(mOffsets[room], mOffsets[room + 1] - mOffsets[room]);
+    }
+
+    // Counting sort of the edge endpoints, neighbours keep the order of the edge list like mConnections does
+    void BuildAdjacency() const
+    {
+        if (!mOffsets.empty() || RoomCount() == 0) {
+            return;
+        }
+
+        mOffsets.assign(RoomCount() + 1, 0);
+        for (const auto& edge : mEdges) {
+            ++mOffsets[edge.mNode1 + 1];
+            ++mOffsets[edge.mNode2 + 1];
+        }
+        for (std::size_t i = 1; i < mOffsets.size(); i++) {
+            mOffsets[i] += mOffsets[i - 1];
+        }
+
+        mNeighbours.resize(mEdges.size() * 2);
+        std::vector<std::uint32_t> cursor(mOffsets.begin(), mOffsets.end() - 1);
+        for (const auto& edge : mEdges) {
+            mNeighbours[cursor[edge.mNode1]++] = edge.mNode2;
+            mNeighbours[cursor[edge.mNode2]++] = edge.mNode1;
+        }
+    }
+
+    void ReleaseAdjacency() const
+    {
+        mOffsets = {};
+        mNeighbours = {};
+    }
+
+    [[nodiscard]] Dungeon ToDungeon() const
+    {
+        Dungeon dungeon;
+        dungeon.mGenerationData = mGenerationData;
+        dungeon.mVertices.reserve(RoomCount());
+
+        for (std::size_t i = 0; i < RoomCount(); i++) {
+            auto& vertex = dungeon.mVertices.emplace_back(mPositions[i].mPx, mPositions[i].mPy, mSizes[i]);
+            vertex.mType = mTypes[i];
+            vertex.mDifficulty = mDifficulty.empty() ? 0.0f : mDifficulty[i];
+        }
+
+        dungeon.mEdges.reserve(mEdges.size());
+        for (const auto& edge : mEdges) {
+            dungeon.mEdges.emplace_back(edge.mNode1, edge.mNode2);
+            dungeon.mVertices[edge.mNode1].mConnections.push_back(edge.mNode2);
+            dungeon.mVertices[edge.mNode2].mConnections.push_back(edge.mNode1);
+        }
+
+        dungeon.mNavMesh = mNavMesh;
+        dungeon.mPathHierarchy = mPathHierarchy;
+        dungeon.mMetrics = mMetrics;
+        return dungeon;
+    }
+
+    [[nodiscard]] MemoryReport MemoryUsage() const
+    {
+        MemoryReport usage{};
+        usage.mRoomCount = RoomCount();
+        usage.mVertices = sizeof(BasicCompactDungeon) + mPositions.capacity() * sizeof(Position)
+            + mSizes.capacity() * sizeof(float) + mTypes.capacity() * sizeof(RoomType) + mDifficulty.capacity() * sizeof(float);
+        usage.mEdges = mEdges.capacity() * sizeof(Edge);
+        usage.mConnections = mOffsets.capacity() * sizeof(std::uint32_t) + mNeighbours.capacity() * sizeof(IndexType);
+        usage.mNavMesh = mNavMesh.MemoryUsage();
+        usage.mPathHierarchy = mPathHierarchy.MemoryUsage();
+
+        for (std::size_t capacity : {mPositions.capacity(), mSizes.capacity(), mTypes.capacity(), mDifficulty.capacity(), mEdges.capacity(), mOffsets.capacity(), mNeighbours.capacity()}) {
+            usage.mAllocatorOverhead += (capacity > 0) * HEAP_BLOCK_OVERHEAD;
+        }
+
+        return usage;
+    }
+
+    GenerationData mGenerationData{};
+
+private:
+    // Receives the rooms and corridors from GenerateInto()
+    struct PackedSink
+    {
+        BasicCompactDungeon& mDungeon;
+
+        void SetVertexCount(std::uint32_t count) const
+        {
+            if (count > static_cast<std::size_t>(std::numeric_limits<IndexType>::max())) {
+                throw std::length_error("Dungeon has too many rooms for the compact index type");
+            }
+            mDungeon.mPositions.resize(count);
+            mDungeon.mSizes.resize(count);
+            mDungeon.mTypes.resize(count);
+            mDungeon.mDifficulty.resize(mDungeon.mGenerationData.mGenerateGameplayContent ? count : 0);
+            mDungeon.mEdges.reserve(RequiredBufferSizes(mDungeon.mGenerationData, count).mEdges);
+        }
+
+        void SetVertex(std::uint32_t index, float x, float y, float size) const
+        {
+            mDungeon.mPositions[index] = { x, y };
+            mDungeon.mSizes[index] = size;
+        }
+
+        void SetType(std::uint32_t index, RoomType type) const
+        {
+            mDungeon.mTypes[index] = type;
+        }
+
+        void SetDifficulty(std::uint32_t index, float difficulty) const
+        {
+            if (!mDungeon.mDifficulty.empty()) {
+                mDungeon.mDifficulty[index] = difficulty;
+            }
+        }
+
+        void SetNavMesh(NavMesh&& navMesh) const
+        {
+            mDungeon.mNavMesh = std::move(navMesh);
+        }
+
+        void SetPathHierarchy(PathHierarchy&& pathHierarchy) const
+        {
+            mDungeon.mPathHierarchy = std::move(pathHierarchy);
+        }
+
+        void SetMetrics(DungeonMetrics&& metrics) const
+        {
+            mDungeon.mMetrics = std::move(metrics);
+        }
+
+        void AddEdge(std::uint32_t a, std::uint32_t b) const
+        {
+            mDungeon.mEdges.push_back({ static_cast<IndexType>(a), static_cast<IndexType>(b) });
+        }
+    };
+
+    std::vector<Position> mPositions{};
+    std::vector<float> mSizes{};
+    std::vector<RoomType> mTypes{};
+    std::vector<float> mDifficulty{};
+    std::vector<Edge> mEdges{};
+    NavMesh mNavMesh{};
+    PathHierarchy mPathHierarchy{};
+    DungeonMetrics mMetrics{};
+
+    // Lazily derived adjacency in compressed sparse row form
+    mutable std::vector<std::uint32_t> mOffsets{};
+    mutable std::vector<IndexType> mNeighbours{};
+};
+
+using CompactDungeon = BasicCompactDungeon<std::uint32_t>;
+
+}
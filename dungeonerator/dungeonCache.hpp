@@ -0,0 +1,465 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace DungeonGenerator
+{
+
+// FNV-1a over a fixed little-endian encoding, so keys are stable across runs and machines
+class StableHasher
+{
+public:
+    void Add(std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) {
+            mHash ^= (value >> (i * 8)) & 0xFFu;
+            mHash *= 1099511628211ull;
+        }
+    }
+
+    void Add(int value) { Add(static_cast<std::uint32_t>(value)); }
+    void Add(bool value) { Add(static_cast<std::uint32_t>(value ? 1 : 0)); }
+    void Add(float value) { Add(std::bit_cast<std::uint32_t>(value == 0.0f ? 0.0f : value)); } // -0 and +0 hash the same
+
+    [[nodiscard]] std::uint64_t Value() const { return mHash; }
+
+private:
+    std::uint64_t mHash = 14695981039346656037ull;
+};
+
+// Calls visit on every field of the generation data in a fixed order, shared by the hash and the disk format
+template <typename Data, typename Visitor>
+void VisitGenerationData(Data& data, Visitor&& visit)
+{
+    visit(data.mNrVertices);
+    visit(data.mNrLoops);
+    visit(data.mMinVertexSize);
+    visit(data.mMaxVertexSize);
+    visit(data.mSizeX);
+    visit(data.mSizeY);
+    visit(data.mSeed);
+    visit(data.mIsCircle);
+    visit(data.mGenerateGameplayContent);
+    visit(data.mTreasureRoomPercentage);
+    visit(data.mContentPlacement);
+    visit(data.mEdgeWeightMode);
+    visit(data.mWeightJitter);
+    visit(data.mBuildNavMesh);
+    visit(data.mBuildPathHierarchy);
+    visit(data.mClusterSize);
+    visit(data.mComputeMetrics);
+}
+
+// Hashes every field of the generation data together with the library version
+inline std::uint64_t HashGenerationData(const GenerationData& data)
+{
+    StableHasher hasher;
+    hasher.Add(LIBRARY_VERSION);
+    VisitGenerationData(data, [&]<typename T>(const T& value)
+        {
+            if constexpr (std::is_enum_v<T>) {
+                hasher.Add(static_cast<std::uint32_t>(value));
+            }
+            else {
+                hasher.Add(value);
+            }
+        });
+    return hasher.Value();
+}
+
+struct CacheStats
+{
+    std::size_t mMemoryHits = 0;
+    std::size_t mDiskHits = 0;
+    std::size_t mSharedGenerations = 0; // Requests that waited on a generation already in flight
+    std::size_t mGenerations = 0;
+    std::size_t mEvictions = 0;
+};
+
+// Memoizes dungeon generation.
+// Dungeons are kept in a bounded LRU in memory and, when a directory is given, written to disk as well.
+// The disk cache is off when the directory cannot be created, see DiskEnabled().
+// Concurrent requests for the same data share a single generation.
+class DungeonCache
+{
+public:
+    using DungeonPtr = std::shared_ptr<const Dungeon>;
+
+    explicit DungeonCache(std::size_t memoryCapacity = 64, std::filesystem::path diskDirectory = {})
+        : mCapacity(std::max<std::size_t>(memoryCapacity, 1)), mDiskDirectory(std::move(diskDirectory))
+    {
+        if (!mDiskDirectory.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(mDiskDirectory, error);
+            if (error) {
+                mDiskDirectory.clear();
+            }
+        }
+    }
+
+    DungeonPtr Get(const GenerationData& generationData);
+
+    void Clear()
+    {
+        std::lock_guard lock(mMutex);
+        mLru.clear();
+        mLookup.clear();
+    }
+
+    [[nodiscard]] CacheStats Stats() const
+    {
+        std::lock_guard lock(mMutex);
+        return mStats;
+    }
+
+    [[nodiscard]] std::size_t Size() const
+    {
+        std::lock_guard lock(mMutex);
+        return mLru.size();
+    }
+
+    [[nodiscard]] bool DiskEnabled() const { return !mDiskDirectory.empty(); }
+
+private:
+    struct Entry
+    {
+        std::uint64_t mKey{};
+        DungeonPtr mDungeon{};
+    };
+
+    [[nodiscard]] std::filesystem::path DiskPath(std::uint64_t key) const;
+    DungeonPtr LoadFromDisk(std::uint64_t key, const GenerationData& generationData) const;
+    void SaveToDisk(std::uint64_t key, const Dungeon& dungeon) const;
+
+    // Requires mMutex to be held
+    void Insert(std::uint64_t key, DungeonPtr dungeon);
+
+    mutable std::mutex mMutex;
+
+    std::size_t mCapacity;
+    std::filesystem::path mDiskDirectory;
+
+    std::list<Entry> mLru{}; // Most recently used at the front
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> mLookup{};
+    std::unordered_map<std::uint64_t, std::shared_future<DungeonPtr>> mInFlight{};
+
+    CacheStats mStats{};
+};
+
+inline DungeonCache::DungeonPtr DungeonCache::Get(const GenerationData& generationData)
+{
+    const std::uint64_t key = HashGenerationData(generationData);
+
+    std::promise<DungeonPtr> promise;
+    {
+        std::unique_lock lock(mMutex);
+
+        if (const auto it = mLookup.find(key); it != mLookup.end() && it->second->mDungeon->mGenerationData == generationData) {
+            mLru.splice(mLru.begin(), mLru, it->second);
+            ++mStats.mMemoryHits;
+            return it->second->mDungeon;
+        }
+
+        if (const auto it = mInFlight.find(key); it != mInFlight.end()) {
+            std::shared_future<DungeonPtr> pending = it->second;
+            ++mStats.mSharedGenerations;
+            lock.unlock();
+
+            DungeonPtr dungeon = pending.get();
+            if (dungeon->mGenerationData == generationData) {
+                return dungeon;
+            }
+            // Hash collision with a different request, generate without caching
+            return std::make_shared<const Dungeon>(generationData);
+        }
+
+        mInFlight.emplace(key, promise.get_future().share());
+    }
+
+    DungeonPtr dungeon{};
+    bool fromDisk = false;
+    try {
+        dungeon = LoadFromDisk(key, generationData);
+        fromDisk = dungeon != nullptr;
+
+        if (!dungeon) {
+            dungeon = std::make_shared<const Dungeon>(generationData);
+            SaveToDisk(key, *dungeon);
+        }
+    } catch (...) {
+        {
+            std::lock_guard lock(mMutex);
+            mInFlight.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        ++(fromDisk ? mStats.mDiskHits : mStats.mGenerations);
+        Insert(key, dungeon);
+        mInFlight.erase(key);
+    }
+
+    promise.set_value(dungeon);
+    return dungeon;
+}
+
+inline void DungeonCache::Insert(std::uint64_t key, DungeonPtr dungeon)
+{
+    if (const auto it = mLookup.find(key); it != mLookup.end()) {
+        mLru.erase(it->second);
+        mLookup.erase(it);
+    }
+
+    mLru.push_front({key, std::move(dungeon)});
+    mLookup[key] = mLru.begin();
+
+    while (mLru.size() > mCapacity) {
+        mLookup.erase(mLru.back().mKey);
+        mLru.pop_back();
+        ++mStats.mEvictions;
+    }
+}
+
+// Disk format, host endianness:
+// magic, version, key, the generation data field by field, vertex count, edge count,
+// vertices (x, y, size, difficulty, type), edges (node1, node2),
+// navmesh triangle count, then when not empty its coordinates, corners, half edges and flags.
+// The generation data is compared on load, so a key collision reads as a miss.
+// The path hierarchy is not stored, it is rebuilt on load.
+// Vertex connections are rebuilt from the edges in their original order.
+namespace CacheFormat
+{
+    constexpr std::uint32_t MAGIC = 0x32474444; // "DDG2"
+    constexpr std::uint64_t VERTEX_BYTES = 4 * sizeof(float) + sizeof(std::uint32_t);
+    constexpr std::uint64_t EDGE_BYTES = 2 * sizeof(std::uint32_t);
+    constexpr std::uint64_t TRIANGLE_BYTES = 6 * sizeof(std::uint32_t) + sizeof(std::uint8_t);
+
+    inline std::string Hex(std::uint64_t value)
+    {
+        std::string name(16, '0');
+        static constexpr char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 16; i++) {
+            name[15 - i] = digits[(value >> (i * 4)) & 0xFu];
+        }
+        return name;
+    }
+
+    template <typename T>
+    void Write(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool Read(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template <typename T>
+    void WriteArray(std::ostream& stream, const std::vector<T>& values)
+    {
+        stream.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    bool ReadArray(std::istream& stream, std::vector<T>& values, std::size_t count)
+    {
+        values.resize(count);
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+
+    // Bytes left between the read position and the end of the file
+    inline std::uint64_t Remaining(std::istream& stream)
+    {
+        const auto position = stream.tellg();
+        stream.seekg(0, std::ios::end);
+        const auto end = stream.tellg();
+        stream.seekg(position);
+        return position < 0 || end < position ? 0 : static_cast<std::uint64_t>(end - position);
+    }
+}
+
+inline std::filesystem::path DungeonCache::DiskPath(std::uint64_t key) const
+{
+    return mDiskDirectory / (CacheFormat::Hex(key) + ".dungeon");
+}
+
+inline DungeonCache::DungeonPtr DungeonCache::LoadFromDisk(std::uint64_t key, const GenerationData& generationData) const
+{
+    if (mDiskDirectory.empty()) {
+        return nullptr;
+    }
+
+    std::ifstream file(DiskPath(key), std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+
+    std::uint32_t magic{}, version{};
+    std::uint64_t storedKey{};
+    if (!CacheFormat::Read(file, magic) || !CacheFormat::Read(file, version) || !CacheFormat::Read(file, storedKey)
+        || magic != CacheFormat::MAGIC || version != LIBRARY_VERSION || storedKey != key) {
+        return nullptr;
+    }
+
+    GenerationData storedData{};
+    bool read = true;
+    VisitGenerationData(storedData, [&](auto& value) { read = read && CacheFormat::Read(file, value); });
+    if (!read || !(storedData == generationData)) {
+        return nullptr;
+    }
+
+    // The counts must fit in the file before anything is allocated for them
+    std::uint64_t vertexCount{}, edgeCount{};
+    if (!CacheFormat::Read(file, vertexCount) || !CacheFormat::Read(file, edgeCount)) {
+        return nullptr;
+    }
+    const std::uint64_t remaining = CacheFormat::Remaining(file);
+    if (vertexCount > remaining / CacheFormat::VERTEX_BYTES || edgeCount > remaining / CacheFormat::EDGE_BYTES
+        || vertexCount * CacheFormat::VERTEX_BYTES + edgeCount * CacheFormat::EDGE_BYTES > remaining) {
+        return nullptr;
+    }
+
+    auto dungeon = std::make_shared<Dungeon>();
+    dungeon->mGenerationData = generationData;
+    dungeon->mVertices.resize(vertexCount);
+    dungeon->mEdges.resize(edgeCount);
+
+    for (auto& vertex : dungeon->mVertices) {
+        std::uint32_t type{};
+        if (!CacheFormat::Read(file, vertex.mPx) || !CacheFormat::Read(file, vertex.mPy)
+            || !CacheFormat::Read(file, vertex.mSize) || !CacheFormat::Read(file, vertex.mDifficulty) || !CacheFormat::Read(file, type)
+            || type >= static_cast<std::uint32_t>(RoomType::NUM_TYPES)) {
+            return nullptr;
+        }
+        vertex.mType = static_cast<RoomType>(type);
+    }
+
+    for (auto& edge : dungeon->mEdges) {
+        if (!CacheFormat::Read(file, edge.mNode1) || !CacheFormat::Read(file, edge.mNode2)
+            || edge.mNode1 >= vertexCount || edge.mNode2 >= vertexCount) {
+            return nullptr;
+        }
+        dungeon->mVertices[edge.mNode1].mConnections.push_back(edge.mNode2);
+        dungeon->mVertices[edge.mNode2].mConnections.push_back(edge.mNode1);
+    }
+
+    std::uint64_t triangleCount{};
+    if (!CacheFormat::Read(file, triangleCount)) {
+        return nullptr;
+    }
+    if (triangleCount > 0) {
+        const std::uint64_t meshBytes = CacheFormat::Remaining(file);
+        if (triangleCount > meshBytes / CacheFormat::TRIANGLE_BYTES
+            || vertexCount * 2 * sizeof(float) + triangleCount * CacheFormat::TRIANGLE_BYTES > meshBytes) {
+            return nullptr;
+        }
+        auto& navMesh = dungeon->mNavMesh;
+        if (!CacheFormat::ReadArray(file, navMesh.mCoords, vertexCount * 2) || !CacheFormat::ReadArray(file, navMesh.mTriangles, triangleCount * 3)
+            || !CacheFormat::ReadArray(file, navMesh.mHalfEdges, triangleCount * 3) || !CacheFormat::ReadArray(file, navMesh.mFlags, triangleCount)) {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < navMesh.mTriangles.size(); i++) {
+            if (navMesh.mTriangles[i] >= vertexCount || (navMesh.mHalfEdges[i] != NavMesh::INVALID && navMesh.mHalfEdges[i] >= navMesh.mHalfEdges.size())) {
+                return nullptr;
+            }
+        }
+    }
+
+    // Derived from the rooms and edges only, cheaper to rebuild than to store
+    if (generationData.mBuildPathHierarchy) {
+        std::vector<float> positions;
+        positions.reserve(vertexCount * 2);
+        for (const auto& vertex : dungeon->mVertices) {
+            positions.push_back(vertex.mPx);
+            positions.push_back(vertex.mPy);
+        }
+        const unsigned threadCount = vertexCount >= PARALLEL_HIERARCHY_ROOMS ? std::thread::hardware_concurrency() : 1;
+        dungeon->mPathHierarchy = PathHierarchy(positions, RoomGraph(vertexCount, dungeon->mEdges), generationData.mClusterSize, threadCount);
+    }
+    if (generationData.mComputeMetrics) {
+        dungeon->mMetrics = ComputeDungeonMetrics(*dungeon);
+    }
+
+    return dungeon;
+}
+
+inline void DungeonCache::SaveToDisk(std::uint64_t key, const Dungeon& dungeon) const
+{
+    if (mDiskDirectory.empty()) {
+        return;
+    }
+
+    // Write to a temporary file first so concurrent readers never see a partial file.
+    // The random name keeps writers in other processes sharing the directory apart as well.
+    const auto path = DiskPath(key);
+    std::random_device device;
+    auto tempPath = path;
+    tempPath += ".tmp" + CacheFormat::Hex((static_cast<std::uint64_t>(device()) << 32) ^ device());
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return;
+        }
+
+        CacheFormat::Write(file, CacheFormat::MAGIC);
+        CacheFormat::Write(file, LIBRARY_VERSION);
+        CacheFormat::Write(file, key);
+        VisitGenerationData(dungeon.mGenerationData, [&](const auto& value) { CacheFormat::Write(file, value); });
+        CacheFormat::Write(file, static_cast<std::uint64_t>(dungeon.mVertices.size()));
+        CacheFormat::Write(file, static_cast<std::uint64_t>(dungeon.mEdges.size()));
+
+        for (const auto& vertex : dungeon.mVertices) {
+            CacheFormat::Write(file, vertex.mPx);
+            CacheFormat::Write(file, vertex.mPy);
+            CacheFormat::Write(file, vertex.mSize);
+            CacheFormat::Write(file, vertex.mDifficulty);
+            CacheFormat::Write(file, static_cast<std::uint32_t>(vertex.mType));
+        }
+
+        for (const auto& edge : dungeon.mEdges) {
+            CacheFormat::Write(file, edge.mNode1);
+            CacheFormat::Write(file, edge.mNode2);
+        }
+
+        CacheFormat::Write(file, static_cast<std::uint64_t>(dungeon.mNavMesh.TriangleCount()));
+        if (!dungeon.mNavMesh.Empty()) {
+            CacheFormat::WriteArray(file, dungeon.mNavMesh.mCoords);
+            CacheFormat::WriteArray(file, dungeon.mNavMesh.mTriangles);
+            CacheFormat::WriteArray(file, dungeon.mNavMesh.mHalfEdges);
+            CacheFormat::WriteArray(file, dungeon.mNavMesh.mFlags);
+        }
+
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <charconv>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace DungeonGenerator
+{
+
+enum class ExportFormat : std::uint8_t
+{
+    JSON, // {"rooms": [{x, y, size, type, difficulty}], "edges": [[node1, node2]]}
+    GRAPHML,
+    OBJ, // A point per room, a line per edge
+    CSV_ROOMS, // id,x,y,size,type,difficulty
+    CSV_EDGES, // node1,node2
+};
+
+struct ExportSettings
+{
+    std::size_t mBufferSize = 1 << 20; // Bytes per block, a block is formatted in one piece before it is written
+    unsigned mThreadCount = 1; // Threads formatting blocks of rooms and edges, above 1 another thread writes. The output is the same for any count
+};
+
+// Character buffer with std::to_chars formatting, reserved up front so appending does not reallocate
+class ExportBuffer
+{
+public:
+    explicit ExportBuffer(std::size_t capacity = 0) { mData.reserve(capacity); }
+
+    void Append(std::string_view text) { mData.append(text); }
+    void Append(char character) { mData.push_back(character); }
+
+    // Shortest representation that reads back to the same float
+    void Append(float value)
+    {
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        mData.append(digits, result.ptr);
+    }
+
+    void Append(std::uint32_t value)
+    {
+        char digits[16];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        mData.append(digits, result.ptr);
+    }
+
+    void Clear() { mData.clear(); }
+    [[nodiscard]] std::string_view View() const { return mData; }
+
+private:
+    std::string mData{};
+};
+
+namespace ExportDetail
+{
+    // Upper estimates of the formatted size of one room or edge, they only decide the block size
+    constexpr std::size_t ROOM_BYTES = 160;
+    constexpr std::size_t EDGE_BYTES = 48;
+
+    // Formats [0, count) in blocks with format(begin, end, buffer) and writes the blocks in order.
+    // The formatting threads run for the whole export and take the next block as soon as their last one is in a
+    // buffer, while another thread writes the finished blocks. Memory stays at two buffers per formatting thread.
+    template <typename Fn>
+    void WriteBlocks(std::ostream& stream, std::size_t count, std::size_t itemBytes, const ExportSettings& settings, const Fn& format)
+    {
+        const unsigned threadCount = std::max(settings.mThreadCount, 1u);
+        const std::size_t blockSize = std::max<std::size_t>(settings.mBufferSize / itemBytes, 1);
+        const std::size_t blockCount = (count + blockSize - 1) / blockSize;
+
+        if (threadCount == 1 || blockCount <= 1) {
+            ExportBuffer buffer(std::min(blockSize, count) * itemBytes);
+            for (std::size_t begin = 0; begin < count && stream; begin += blockSize) {
+                buffer.Clear();
+                format(begin, std::min(count, begin + blockSize), buffer);
+                stream.write(buffer.View().data(), static_cast<std::streamsize>(buffer.View().size()));
+            }
+            return;
+        }
+
+        const std::size_t slotCount = std::min<std::size_t>(2 * threadCount, blockCount);
+        std::vector<ExportBuffer> buffers;
+        buffers.reserve(slotCount);
+        for (std::size_t i = 0; i < slotCount; i++) {
+            buffers.emplace_back(blockSize * itemBytes);
+        }
+        std::vector<bool> formatted(slotCount, false);
+        std::size_t written = 0;
+        bool failed = false;
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        std::thread writer([&]()
+            {
+                for (std::size_t block = 0; block < blockCount; block++) {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&]() { return formatted[block % slotCount]; });
+                    lock.unlock();
+
+                    const auto text = buffers[block % slotCount].View();
+                    const bool good = static_cast<bool>(stream.write(text.data(), static_cast<std::streamsize>(text.size())));
+
+                    lock.lock();
+                    formatted[block % slotCount] = false;
+                    written = block + 1;
+                    failed = !good;
+                    changed.notify_all();
+                    if (failed) {
+                        return;
+                    }
+                }
+            });
+
+        ParallelForEach(blockCount, threadCount, [&](std::size_t block)
+            {
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&]() { return failed || block < written + slotCount; });
+                    if (failed) {
+                        return false;
+                    }
+                }
+
+                auto& buffer = buffers[block % slotCount];
+                buffer.Clear();
+                const std::size_t begin = block * blockSize;
+                format(begin, std::min(count, begin + blockSize), buffer);
+
+                std::lock_guard lock(mutex);
+                formatted[block % slotCount] = true;
+                changed.notify_all();
+                return true;
+            });
+
+        writer.join();
+    }
+
+    inline void Write(std::ostream& stream, std::string_view text)
+    {
+        stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    inline void ExportJson(const Dungeon& dungeon, std::ostream& stream, const ExportSettings& settings)
+    {
+        Write(stream, "{\n\"rooms\": [\n");
+        WriteBlocks(stream, dungeon.mVertices.size(), ROOM_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    const auto& vertex = dungeon.mVertices[i];
+                    buffer.Append(i == 0 ? "{\"x\": " : ",\n{\"x\": ");
+                    buffer.Append(vertex.mPx);
+                    buffer.Append(", \"y\": ");
+                    buffer.Append(vertex.mPy);
+                    buffer.Append(", \"size\": ");
+                    buffer.Append(vertex.mSize);
+                    buffer.Append(", \"type\": \"");
+                    buffer.Append(RoomTypeName(vertex.mType));
+                    buffer.Append("\", \"difficulty\": ");
+                    buffer.Append(vertex.mDifficulty);
+                    buffer.Append('}');
+                }
+            });
+
+        Write(stream, "\n],\n\"edges\": [\n");
+        WriteBlocks(stream, dungeon.mEdges.size(), EDGE_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    buffer.Append(i == 0 ? "[" : ",\n[");
+                    buffer.Append(dungeon.mEdges[i].mNode1);
+                    buffer.Append(", ");
+                    buffer.Append(dungeon.mEdges[i].mNode2);
+                    buffer.Append(']');
+                }
+            });
+        Write(stream, "\n]\n}\n");
+    }
+
+    inline void ExportGraphML(const Dungeon& dungeon, std::ostream& stream, const ExportSettings& settings)
+    {
+        Write(stream,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+            "<key id=\"x\" for=\"node\" attr.name=\"x\" attr.type=\"float\"/>\n"
+            "<key id=\"y\" for=\"node\" attr.name=\"y\" attr.type=\"float\"/>\n"
+            "<key id=\"size\" for=\"node\" attr.name=\"size\" attr.type=\"float\"/>\n"
+            "<key id=\"type\" for=\"node\" attr.name=\"type\" attr.type=\"string\"/>\n"
+            "<key id=\"difficulty\" for=\"node\" attr.name=\"difficulty\" attr.type=\"float\"/>\n"
+            "<graph id=\"dungeon\" edgedefault=\"undirected\">\n");
+
+        WriteBlocks(stream, dungeon.mVertices.size(), 2 * ROOM_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    const auto& vertex = dungeon.mVertices[i];
+                    buffer.Append("<node id=\"n");
+                    buffer.Append(static_cast<std::uint32_t>(i));
+                    buffer.Append("\"><data key=\"x\">");
+                    buffer.Append(vertex.mPx);
+                    buffer.Append("</data><data key=\"y\">");
+                    buffer.Append(vertex.mPy);
+                    buffer.Append("</data><data key=\"size\">");
+                    buffer.Append(vertex.mSize);
+                    buffer.Append("</data><data key=\"type\">");
+                    buffer.Append(RoomTypeName(vertex.mType));
+                    buffer.Append("</data><data key=\"difficulty\">");
+                    buffer.Append(vertex.mDifficulty);
+                    buffer.Append("</data></node>\n");
+                }
+            });
+
+        WriteBlocks(stream, dungeon.mEdges.size(), EDGE_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    buffer.Append("<edge source=\"n");
+                    buffer.Append(dungeon.mEdges[i].mNode1);
+                    buffer.Append("\" target=\"n");
+                    buffer.Append(dungeon.mEdges[i].mNode2);
+                    buffer.Append("\"/>\n");
+                }
+            });
+
+        Write(stream, "</graph>\n</graphml>\n");
+    }
+
+    // Rooms lie in the xz plane, OBJ indices start at 1
+    inline void ExportObj(const Dungeon& dungeon, std::ostream& stream, const ExportSettings& settings)
+    {
+        Write(stream, "o dungeon\n");
+        WriteBlocks(stream, dungeon.mVertices.size(), ROOM_BYTES / 2, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    buffer.Append("v ");
+                    buffer.Append(dungeon.mVertices[i].mPx);
+                    buffer.Append(" 0 ");
+                    buffer.Append(dungeon.mVertices[i].mPy);
+                    buffer.Append('\n');
+                }
+            });
+
+        WriteBlocks(stream, dungeon.mEdges.size(), EDGE_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    buffer.Append("l ");
+                    buffer.Append(dungeon.mEdges[i].mNode1 + 1);
+                    buffer.Append(' ');
+                    buffer.Append(dungeon.mEdges[i].mNode2 + 1);
+                    buffer.Append('\n');
+                }
+            });
+    }
+
+    inline void ExportCsvRooms(const Dungeon& dungeon, std::ostream& stream, const ExportSettings& settings)
+    {
+        Write(stream, "id,x,y,size,type,difficulty\n");
+        WriteBlocks(stream, dungeon.mVertices.size(), ROOM_BYTES / 2, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    const auto& vertex = dungeon.mVertices[i];
+                    buffer.Append(static_cast<std::uint32_t>(i));
+                    buffer.Append(',');
+                    buffer.Append(vertex.mPx);
+                    buffer.Append(',');
+                    buffer.Append(vertex.mPy);
+                    buffer.Append(',');
+                    buffer.Append(vertex.mSize);
+                    buffer.Append(',');
+                    buffer.Append(RoomTypeName(vertex.mType));
+                    buffer.Append(',');
+                    buffer.Append(vertex.mDifficulty);
+                    buffer.Append('\n');
+                }
+            });
+    }
+
+    inline void ExportCsvEdges(const Dungeon& dungeon, std::ostream& stream, const ExportSettings& settings)
+    {
+        Write(stream, "node1,node2\n");
+        WriteBlocks(stream, dungeon.mEdges.size(), EDGE_BYTES, settings, [&](std::size_t begin, std::size_t end, ExportBuffer& buffer)
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    buffer.Append(dungeon.mEdges[i].mNode1);
+                    buffer.Append(',');
+                    buffer.Append(dungeon.mEdges[i].mNode2);
+                    buffer.Append('\n');
+                }
+            });
+    }
+}
+
+// Streams the dungeon in the given format, returns false when writing to the stream failed
+inline bool ExportDungeon(const Dungeon& dungeon, ExportFormat format, std::ostream& stream, const ExportSettings& settings = {})
+{
+    switch (format) {
+    case ExportFormat::JSON:
+        ExportDetail::ExportJson(dungeon, stream, settings);
+        break;
+    case ExportFormat::GRAPHML:
+        ExportDetail::ExportGraphML(dungeon, stream, settings);
+        break;
+    case ExportFormat::OBJ:
+        ExportDetail::ExportObj(dungeon, stream, settings);
+        break;
+    case ExportFormat::CSV_ROOMS:
+        ExportDetail::ExportCsvRooms(dungeon, stream, settings);
+        break;
+    case ExportFormat::CSV_EDGES:
+        ExportDetail::ExportCsvEdges(dungeon, stream, settings);
+        break;
+    }
+
+    return static_cast<bool>(stream.flush());
+}
+
+// Returns false when the file cannot be opened or writing to it failed
+inline bool ExportDungeon(const Dungeon& dungeon, ExportFormat format, const std::filesystem::path& path, const ExportSettings& settings = {})
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    return ExportDungeon(dungeon, format, file, settings);
+}
+
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+#include "pointGrid.hpp"
+
+namespace DungeonGenerator
+{
+
+struct FloorGenerationData
+{
+    GenerationData mFloor{}; // Settings of every floor, each floor gets its own seed from FloorSeed()
+    int mFloorCount = 2;
+    int mStairsPerFloor = 1; // Stairs from every floor to the one above, fewer when two land in the same room
+    unsigned mThreadCount = 0; // Threads for all floors together, 0 uses every hardware thread
+};
+
+// Floor 0 keeps the seed, so it matches a single floor dungeon with the same GenerationData
+inline int FloorSeed(int seed, int floor)
+{
+    if (floor == 0) {
+        return seed;
+    }
+    return 1 + static_cast<int>(RoomRandom(static_cast<std::uint64_t>(seed), static_cast<std::uint32_t>(floor)) * 16777216.0f);
+}
+
+namespace FloorDetail
+{
+    // Floors generated at the same time share the threads
+    struct FloorSink : DungeonSink
+    {
+        unsigned mThreadCount;
+
+        unsigned ThreadCount() const { return mThreadCount; }
+    };
+}
+
+// Stacked floors in one graph. The floors are generated in parallel, each by the single floor pipeline,
+// and consecutive floors are linked by stairs from random rooms to the nearest room on the floor above.
+// Gameplay content is placed once over all floors: START lies on floor 0, BOSS on the last floor and the
+// difficulty ramps with the distance from START through the stairs. A single floor keeps its own content.
+class MultiFloorDungeon
+{
+public:
+    Dungeon mDungeon{}; // Rooms of all floors, mEdges holds the corridors of every floor and the stairs
+    std::vector<std::uint32_t> mFloorOffsets{}; // Rooms of floor f are [mFloorOffsets[f], mFloorOffsets[f + 1])
+    std::vector<DungeonEdge> mStairs{}; // mNode1 lies on the lower floor
+    std::vector<NavMesh> mNavMeshes{}; // One per floor with floor local room indices, empty unless mBuildNavMesh is set
+
+    MultiFloorDungeon() = default;
+
+    explicit MultiFloorDungeon(const FloorGenerationData& floorData)
+    {
+        Generate(floorData);
+    }
+
+    [[nodiscard]] std::uint32_t FloorCount() const { return mFloorOffsets.empty() ? 0 : static_cast<std::uint32_t>(mFloorOffsets.size() - 1); }
+
+    [[nodiscard]] std::uint32_t FloorOf(std::uint32_t room) const
+    {
+        return static_cast<std::uint32_t>(std::upper_bound(mFloorOffsets.begin(), mFloorOffsets.end(), room) - mFloorOffsets.begin() - 1);
+    }
+
+    [[nodiscard]] std::span<const DungeonVertex> FloorRooms(std::uint32_t floor) const
+    {
+        return std::span<const DungeonVertex>(mDungeon.mVertices).subspan(mFloorOffsets[floor], mFloorOffsets[floor + 1] - mFloorOffsets[floor]);
+    }
+
+private:
+    void Generate(const FloorGenerationData& floorData);
+    void PlaceContent(unsigned threadCount);
+};
+
+inline void MultiFloorDungeon::Generate(const FloorGenerationData& floorData)
+{
+    const auto floorCount = static_cast<std::size_t>(std::max(floorData.mFloorCount, 1));
+    const unsigned threadCount = std::max(floorData.mThreadCount == 0 ? std::thread::hardware_concurrency() : floorData.mThreadCount, 1u);
+    const unsigned floorThreads = std::max(threadCount / static_cast<unsigned>(std::min<std::size_t>(floorCount, threadCount)), 1u);
+    mDungeon.mGenerationData = floorData.mFloor;
+
+    // The path hierarchy, the metrics and with several floors the content are done once over all floors instead
+    std::vector<Dungeon> floors(floorCount);
+    ParallelFor(floorCount, threadCount, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t floor = begin; floor < end; floor++) {
+                auto& dungeon = floors[floor];
+                dungeon.mGenerationData = floorData.mFloor;
+                dungeon.mGenerationData.mSeed = FloorSeed(floorData.mFloor.mSeed, static_cast<int>(floor));
+                dungeon.mGenerationData.mGenerateGameplayContent = floorData.mFloor.mGenerateGameplayContent && floorCount == 1;
+                dungeon.mGenerationData.mBuildPathHierarchy = false;
+                dungeon.mGenerationData.mComputeMetrics = false;
+                FloorDetail::FloorSink sink{ { dungeon }, floorThreads };
+                GenerateInto(dungeon.mGenerationData, sink);
+            }
+        });
+
+    mFloorOffsets.assign(floorCount + 1, 0);
+    std::vector<std::size_t> edgeOffsets(floorCount + 1, 0);
+    for (std::size_t floor = 0; floor < floorCount; floor++) {
+        mFloorOffsets[floor + 1] = mFloorOffsets[floor] + static_cast<std::uint32_t>(floors[floor].mVertices.size());
+        edgeOffsets[floor + 1] = edgeOffsets[floor] + floors[floor].mEdges.size();
+    }
+
+    // Stairs, every pair of floors on its own: a grid over the upper floor answers the nearest room queries
+    const auto stairCount = static_cast<std::uint32_t>(std::max(floorData.mStairsPerFloor, 0));
+    std::vector<std::vector<DungeonEdge>> floorStairs(floorCount);
+    ParallelFor(floorCount - 1, threadCount, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t floor = begin; floor < end; floor++) {
+                const auto& lower = floors[floor].mVertices;
+                const auto& upper = floors[floor + 1].mVertices;
+
+                float minX = std::numeric_limits<float>::max(), minY = minX, maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+                for (const auto& vertex : upper) {
+                    minX = std::min(minX, vertex.mPx);
+                    minY = std::min(minY, vertex.mPy);
+                    maxX = std::max(maxX, vertex.mPx);
+                    maxY = std::max(maxY, vertex.mPy);
+                }
+                const float extent = std::max({ maxX - minX, maxY - minY, 1e-6f });
+                PointGrid grid(minX, minY, extent, extent / std::sqrt(static_cast<float>(upper.size())));
+                for (const auto& vertex : upper) {
+                    grid.Insert(vertex.mPx, vertex.mPy);
+                }
+
+                const int seed = FloorSeed(floorData.mFloor.mSeed, static_cast<int>(floor));
+                auto& stairs = floorStairs[floor];
+                for (std::uint32_t stair = 0; stair < stairCount; stair++) {
+                    const auto room = std::min(static_cast<std::uint32_t>(RoomRandom(static_cast<std::uint64_t>(seed), stair) * static_cast<float>(lower.size())),
+                        static_cast<std::uint32_t>(lower.size() - 1));
+                    const std::uint32_t target = grid.Nearest(lower[room].mPx, lower[room].mPy);
+                    stairs.emplace_back(mFloorOffsets[floor] + room, mFloorOffsets[floor + 1] + target);
+                }
+
+                std::sort(stairs.begin(), stairs.end(), [](const DungeonEdge& a, const DungeonEdge& b)
+                    {
+                        return std::pair(a.mNode1, a.mNode2) < std::pair(b.mNode1, b.mNode2);
+                    });
+                stairs.erase(std::unique(stairs.begin(), stairs.end(), [](const DungeonEdge& a, const DungeonEdge& b)
+                    {
+                        return a.mNode1 == b.mNode1 && a.mNode2 == b.mNode2;
+                    }), stairs.end());
+            }
+        });
+
+    // Every floor is moved to its range with the indices shifted by the floor offset
+    auto& vertices = mDungeon.mVertices;
+    auto& edges = mDungeon.mEdges;
+    vertices.resize(mFloorOffsets.back());
+    edges.resize(edgeOffsets.back());
+    mNavMeshes.resize(floorData.mFloor.mBuildNavMesh ? floorCount : 0);
+    ParallelFor(floorCount, threadCount, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t floor = begin; floor < end; floor++) {
+                const std::uint32_t offset = mFloorOffsets[floor];
+                auto& dungeon = floors[floor];
+                for (std::size_t i = 0; i < dungeon.mVertices.size(); i++) {
+                    auto& vertex = vertices[offset + i];
+                    vertex = std::move(dungeon.mVertices[i]);
+                    for (auto& connection : vertex.mConnections) {
+                        connection += offset;
+                    }
+                }
+                for (std::size_t i = 0; i < dungeon.mEdges.size(); i++) {
+                    edges[edgeOffsets[floor] + i] = { dungeon.mEdges[i].mNode1 + offset, dungeon.mEdges[i].mNode2 + offset };
+                }
+                if (!mNavMeshes.empty()) {
+                    mNavMeshes[floor] = std::move(dungeon.mNavMesh);
+                }
+                dungeon = {};
+            }
+        });
+
+    for (const auto& stairs : floorStairs) {
+        for (const auto& stair : stairs) {
+            vertices[stair.mNode1].mConnections.push_back(stair.mNode2);
+            vertices[stair.mNode2].mConnections.push_back(stair.mNode1);
+            edges.push_back(stair);
+            mStairs.push_back(stair);
+        }
+    }
+
+    if (floorData.mFloor.mGenerateGameplayContent && floorCount > 1) {
+        PlaceContent(threadCount);
+    }
+
+    if (floorData.mFloor.mBuildPathHierarchy) {
+        std::vector<float> positions;
+        positions.reserve(vertices.size() * 2);
+        for (const auto& vertex : vertices) {
+            positions.push_back(vertex.mPx);
+            positions.push_back(vertex.mPy);
+        }
+        const unsigned hierarchyThreads = vertices.size() >= PARALLEL_HIERARCHY_ROOMS ? threadCount : 1;
+        mDungeon.mPathHierarchy = PathHierarchy(positions, RoomGraph(vertices.size(), edges), floorData.mFloor.mClusterSize, hierarchyThreads);
+    }
+    if (floorData.mFloor.mComputeMetrics) {
+        mDungeon.mMetrics = ComputeDungeonMetrics(mDungeon);
+    }
+}
+
+// The placements of the single floor pipeline over the graph of all floors. RANDOM keeps START and BOSS on the
+// first and last room, which lie on floor 0 and on the last floor. GRAPH takes the room of floor 0 farthest from
+// the last floor as START, found by two sweeps like on a single floor, and BOSS as on a single floor but only
+// among the rooms of the last floor.
+inline void MultiFloorDungeon::PlaceContent(unsigned threadCount)
+{
+    const GenerationData& data = mDungeon.mGenerationData;
+    auto& vertices = mDungeon.mVertices;
+    const RoomGraph graph(vertices.size(), mDungeon.mEdges);
+    const std::uint32_t roomCount = graph.RoomCount();
+    const std::uint32_t topFloor = mFloorOffsets[FloorCount() - 1];
+    std::vector<RoomType> types(roomCount, RoomType::ENEMY);
+    std::vector<float> difficulty(roomCount, 0.0f);
+
+    if (data.mContentPlacement == ContentPlacement::RANDOM) {
+        std::mt19937 typeGen(data.mSeed);
+        std::uniform_real_distribution<float> roomTypeDistribution(0.0f, 1.0f);
+        for (auto& type : types) {
+            type = roomTypeDistribution(typeGen) < data.mTreasureRoomPercentage ? RoomType::TREASURE : RoomType::ENEMY;
+        }
+        types.front() = RoomType::START;
+        types.back() = RoomType::BOSS;
+
+        const RoomMetrics metrics = ComputeRoomMetrics(graph, 0);
+        const ContentContext context{ graph, metrics, data, {}, difficulty };
+        for (std::uint32_t room = 0; room < roomCount; room++) {
+            DifficultyRule(context, room);
+        }
+    }
+    else {
+        // Lowest room in [first, last) farthest from the source of metrics, unreachable rooms count as closest
+        const auto& farthest = [](const RoomMetrics& metrics, std::uint32_t first, std::uint32_t last)
+            {
+                std::uint32_t result = first, maxDistance = 0;
+                for (std::uint32_t room = first; room < last; room++) {
+                    if (metrics.mDistance[room] != UNREACHABLE_ROOM && metrics.mDistance[room] > maxDistance) {
+                        maxDistance = metrics.mDistance[room];
+                        result = room;
+                    }
+                }
+                return result;
+            };
+
+        const std::uint32_t top = farthest(ComputeRoomMetrics(graph, 0), topFloor, roomCount);
+        RoomMetrics metrics = ComputeRoomMetrics(graph, farthest(ComputeRoomMetrics(graph, top), 0, mFloorOffsets[1]));
+        PlaceBoss(graph, metrics, topFloor, roomCount);
+
+        const auto rules = DefaultContentRules();
+        ApplyContentRules(graph, data, metrics, types, difficulty, rules, roomCount >= PARALLEL_CONTENT_ROOMS ? threadCount : 1);
+    }
+
+    for (std::uint32_t room = 0; room < roomCount; room++) {
+        vertices[room].mType = types[room];
+        vertices[room].mDifficulty = difficulty[room];
+    }
+}
+
+}
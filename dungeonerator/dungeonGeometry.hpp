@@ -0,0 +1,288 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <array>
+#include <limits>
+
+namespace DungeonGenerator
+{
+
+struct GeometryPoint
+{
+    float mX{};
+    float mY{};
+};
+
+// Axis aligned footprint of a room
+struct RoomRect
+{
+    float mMinX{};
+    float mMinY{};
+    float mMaxX{};
+    float mMaxY{};
+
+    [[nodiscard]] bool Contains(GeometryPoint point) const
+    {
+        return point.mX >= mMinX && point.mX <= mMaxX && point.mY >= mMinY && point.mY <= mMaxY;
+    }
+
+    // Axis aligned segment against the rectangle grown by padding on every side
+    [[nodiscard]] bool Touches(GeometryPoint a, GeometryPoint b, float padding) const
+    {
+        return std::max(a.mX, b.mX) >= mMinX - padding && std::min(a.mX, b.mX) <= mMaxX + padding
+            && std::max(a.mY, b.mY) >= mMinY - padding && std::min(a.mY, b.mY) <= mMaxY + padding;
+    }
+};
+
+// Axis aligned polyline from the border of the first room of its edge to the border of the second
+struct Corridor
+{
+    static constexpr std::size_t MAX_POINTS = 4;
+
+    std::array<GeometryPoint, MAX_POINTS> mPoints{};
+    std::uint8_t mPointCount = 0;
+    std::uint32_t mCrossedRooms = 0; // Other rooms the corridor runs through, 0 unless every route is blocked
+
+    [[nodiscard]] std::span<const GeometryPoint> Points() const { return std::span<const GeometryPoint>(mPoints).first(mPointCount); }
+};
+
+struct GeometrySettings
+{
+    float mMaxAspect = 1.5f; // Longest over shortest side of the room rectangles, the aspect is random per room
+    float mCorridorWidth = 0.5f; // Clearance the corridors keep from other rooms
+    unsigned mThreadCount = 1; // Threads routing corridors, the output is the same for any count
+};
+
+// Concrete room rectangles and corridor polylines of a dungeon.
+// A room of size s becomes a rectangle of area 4 s^2 around its centre. Every edge is routed as the first of a
+// straight, L shaped or Z shaped corridor that stays clear of the other rooms, the rectangles are looked up
+// in a uniform grid so a route is checked against the rooms along it only.
+class DungeonGeometry
+{
+public:
+    std::vector<RoomRect> mRooms{}; // Per room
+    std::vector<Corridor> mCorridors{}; // Per edge, in the order of Dungeon::mEdges
+
+    DungeonGeometry() = default;
+
+    explicit DungeonGeometry(const Dungeon& dungeon, const GeometrySettings& settings = {})
+    {
+        BuildRooms(dungeon, settings);
+        BuildGrid(settings.mCorridorWidth * 0.5f);
+
+        mCorridors.resize(dungeon.mEdges.size());
+        ParallelFor(dungeon.mEdges.size(), settings.mThreadCount, [&](std::size_t begin, std::size_t end)
+            {
+                std::vector<std::uint32_t> stamps(mRooms.size(), 0);
+                std::uint32_t stamp = 0;
+                for (std::size_t i = begin; i < end; i++) {
+                    mCorridors[i] = Route(dungeon.mEdges[i].mNode1, dungeon.mEdges[i].mNode2, settings.mCorridorWidth * 0.5f, stamps, stamp);
+                }
+            });
+    }
+
+    [[nodiscard]] std::size_t BlockedCorridorCount() const
+    {
+        return static_cast<std::size_t>(std::count_if(mCorridors.begin(), mCorridors.end(), [](const Corridor& corridor) { return corridor.mCrossedRooms > 0; }));
+    }
+
+private:
+    void BuildRooms(const Dungeon& dungeon, const GeometrySettings& settings)
+    {
+        const float logAspect = std::log(std::max(settings.mMaxAspect, 1.0f));
+        const auto seed = static_cast<std::uint64_t>(dungeon.mGenerationData.mSeed);
+
+        mRooms.resize(dungeon.mVertices.size());
+        for (std::uint32_t i = 0; i < mRooms.size(); i++) {
+            const auto& vertex = dungeon.mVertices[i];
+            // Half sides size * sqrt(aspect) and size / sqrt(aspect), the aspect log uniform in [1 / max, max]
+            const float stretch = std::exp(logAspect * (RoomRandom(seed, i) - 0.5f));
+            const float halfX = vertex.mSize * stretch, halfY = vertex.mSize / stretch;
+            mRooms[i] = { vertex.mPx - halfX, vertex.mPy - halfY, vertex.mPx + halfX, vertex.mPy + halfY };
+        }
+    }
+
+    // Rectangles grown by padding, listed in every cell they overlap, as offsets into mCellRooms per cell
+    void BuildGrid(float padding)
+    {
+        if (mRooms.empty()) {
+            return;
+        }
+
+        float maxX = std::numeric_limits<float>::lowest(), maxY = maxX, sides = 0.0f;
+        mGridMinX = mGridMinY = std::numeric_limits<float>::max();
+        for (const auto& room : mRooms) {
+            mGridMinX = std::min(mGridMinX, room.mMinX - padding);
+            mGridMinY = std::min(mGridMinY, room.mMinY - padding);
+            maxX = std::max(maxX, room.mMaxX + padding);
+            maxY = std::max(maxY, room.mMaxY + padding);
+            sides += room.mMaxX - room.mMinX + room.mMaxY - room.mMinY;
+        }
+
+        // About twice the average side, so most rooms land in few cells, but no more than four cells per room
+        const float width = maxX - mGridMinX, height = maxY - mGridMinY;
+        const float rooms = static_cast<float>(mRooms.size());
+        mCellSize = std::max({ sides / rooms, std::sqrt(width * height / (4.0f * rooms)), 1e-6f });
+        mGridWidth = static_cast<int>(width / mCellSize) + 1;
+        mGridHeight = static_cast<int>(height / mCellSize) + 1;
+
+        mCellOffsets.assign(static_cast<std::size_t>(mGridWidth) * static_cast<std::size_t>(mGridHeight) + 1, 0);
+        const auto& forCells = [&](const RoomRect& room, const auto& fn)
+            {
+                const int x0 = CellX(room.mMinX - padding), x1 = CellX(room.mMaxX + padding);
+                const int y0 = CellY(room.mMinY - padding), y1 = CellY(room.mMaxY + padding);
+                for (int y = y0; y <= y1; y++) {
+                    for (int x = x0; x <= x1; x++) {
+                        fn(Cell(x, y));
+                    }
+                }
+            };
+
+        for (const auto& room : mRooms) {
+            forCells(room, [&](std::size_t cell) { ++mCellOffsets[cell + 1]; });
+        }
+        for (std::size_t i = 1; i < mCellOffsets.size(); i++) {
+            mCellOffsets[i] += mCellOffsets[i - 1];
+        }
+
+        mCellRooms.resize(mCellOffsets.back());
+        std::vector<std::uint32_t> next(mCellOffsets.begin(), mCellOffsets.end() - 1);
+        for (std::uint32_t i = 0; i < mRooms.size(); i++) {
+            forCells(mRooms[i], [&](std::size_t cell) { mCellRooms[next[cell]++] = i; });
+        }
+    }
+
+    [[nodiscard]] int CellX(float x) const { return std::clamp(static_cast<int>((x - mGridMinX) / mCellSize), 0, mGridWidth - 1); }
+    [[nodiscard]] int CellY(float y) const { return std::clamp(static_cast<int>((y - mGridMinY) / mCellSize), 0, mGridHeight - 1); }
+    [[nodiscard]] std::size_t Cell(int x, int y) const { return static_cast<std::size_t>(y) * static_cast<std::size_t>(mGridWidth) + static_cast<std::size_t>(x); }
+
+    // Rooms other than a and b the polyline runs through, stamps marks rooms already counted by this query
+    [[nodiscard]] std::uint32_t CountCrossings(std::span<const GeometryPoint> points, std::uint32_t a, std::uint32_t b, float padding,
+        std::vector<std::uint32_t>& stamps, std::uint32_t& stamp) const
+    {
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+        stamps[a] = stamps[b] = stamp;
+
+        std::uint32_t crossings = 0;
+        for (std::size_t i = 0; i + 1 < points.size(); i++) {
+            const GeometryPoint from = points[i], to = points[i + 1];
+            const int x0 = CellX(std::min(from.mX, to.mX)), x1 = CellX(std::max(from.mX, to.mX));
+            const int y0 = CellY(std::min(from.mY, to.mY)), y1 = CellY(std::max(from.mY, to.mY));
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    const std::size_t cell = Cell(x, y);
+                    for (std::uint32_t j = mCellOffsets[cell]; j < mCellOffsets[cell + 1]; j++) {
+                        const std::uint32_t room = mCellRooms[j];
+                        if (stamps[room] != stamp && mRooms[room].Touches(from, to, padding)) {
+                            stamps[room] = stamp;
+                            ++crossings;
+                        }
+                    }
+                }
+            }
+        }
+        return crossings;
+    }
+
+    [[nodiscard]] Corridor Route(std::uint32_t a, std::uint32_t b, float padding, std::vector<std::uint32_t>& stamps, std::uint32_t& stamp) const
+    {
+        const RoomRect& roomA = mRooms[a];
+        const RoomRect& roomB = mRooms[b];
+        const GeometryPoint centreA{ (roomA.mMinX + roomA.mMaxX) * 0.5f, (roomA.mMinY + roomA.mMaxY) * 0.5f };
+        const GeometryPoint centreB{ (roomB.mMinX + roomB.mMaxX) * 0.5f, (roomB.mMinY + roomB.mMaxY) * 0.5f };
+
+        // Candidates in order of preference, from centre to centre
+        std::array<Corridor, 6> candidates{};
+        std::size_t candidateCount = 0;
+        const auto& add = [&](std::initializer_list<GeometryPoint> points)
+            {
+                auto& corridor = candidates[candidateCount++];
+                for (const auto& point : points) {
+                    corridor.mPoints[corridor.mPointCount++] = point;
+                }
+            };
+
+        const float overlapMinY = std::max(roomA.mMinY, roomB.mMinY), overlapMaxY = std::min(roomA.mMaxY, roomB.mMaxY);
+        const float overlapMinX = std::max(roomA.mMinX, roomB.mMinX), overlapMaxX = std::min(roomA.mMaxX, roomB.mMaxX);
+        if (overlapMinY <= overlapMaxY) {
+            const float y = (overlapMinY + overlapMaxY) * 0.5f;
+            add({ { centreA.mX, y }, { centreB.mX, y } });
+        }
+        if (overlapMinX <= overlapMaxX) {
+            const float x = (overlapMinX + overlapMaxX) * 0.5f;
+            add({ { x, centreA.mY }, { x, centreB.mY } });
+        }
+        const float midX = (centreA.mX + centreB.mX) * 0.5f, midY = (centreA.mY + centreB.mY) * 0.5f;
+        add({ centreA, { centreB.mX, centreA.mY }, centreB });
+        add({ centreA, { centreA.mX, centreB.mY }, centreB });
+        add({ centreA, { midX, centreA.mY }, { midX, centreB.mY }, centreB });
+        add({ centreA, { centreA.mX, midY }, { centreB.mX, midY }, centreB });
+
+        std::size_t best = 0;
+        std::uint32_t bestCrossings = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < candidateCount; i++) {
+            const std::uint32_t crossings = CountCrossings(candidates[i].Points(), a, b, padding, stamps, stamp);
+            if (crossings < bestCrossings) {
+                best = i;
+                bestCrossings = crossings;
+                if (crossings == 0) {
+                    break;
+                }
+            }
+        }
+
+        Corridor corridor = Trim(candidates[best], roomA, roomB);
+        corridor.mCrossedRooms = bestCrossings;
+        return corridor;
+    }
+
+    // Where the axis aligned segment from inside the room to outside of it leaves the room
+    [[nodiscard]] static GeometryPoint Exit(GeometryPoint inside, GeometryPoint outside, const RoomRect& room)
+    {
+        if (inside.mY == outside.mY) {
+            return { outside.mX > inside.mX ? room.mMaxX : room.mMinX, inside.mY };
+        }
+        return { inside.mX, outside.mY > inside.mY ? room.mMaxY : room.mMinY };
+    }
+
+    // Drops the parts of the polyline inside its end rooms, so it runs from border to border
+    [[nodiscard]] static Corridor Trim(const Corridor& route, const RoomRect& roomA, const RoomRect& roomB)
+    {
+        std::size_t first = 0, last = route.mPointCount - 1;
+        while (first + 1 < last && roomA.Contains(route.mPoints[first + 1])) {
+            ++first;
+        }
+        while (last > first + 1 && roomB.Contains(route.mPoints[last - 1])) {
+            --last;
+        }
+
+        Corridor corridor{};
+        for (std::size_t i = first; i <= last; i++) {
+            corridor.mPoints[corridor.mPointCount++] = route.mPoints[i];
+        }
+        auto& points = corridor.mPoints;
+        const std::size_t end = corridor.mPointCount - 1;
+        // Rooms that overlap leave nothing to trim
+        if (roomA.Contains(points[0]) && !roomA.Contains(points[1])) {
+            points[0] = Exit(points[0], points[1], roomA);
+        }
+        if (roomB.Contains(points[end]) && !roomB.Contains(points[end - 1])) {
+            points[end] = Exit(points[end], points[end - 1], roomB);
+        }
+        return corridor;
+    }
+
+    float mGridMinX = 0.0f;
+    float mGridMinY = 0.0f;
+    float mCellSize = 1.0f;
+    int mGridWidth = 1;
+    int mGridHeight = 1;
+    std::vector<std::uint32_t> mCellOffsets{};
+    std::vector<std::uint32_t> mCellRooms{};
+};
+
+}
@@ -0,0 +1,563 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+#include "pointGrid.hpp"
+
+#include <limits>
+#include <tuple>
+
+namespace DungeonGenerator
+{
+
+// Circle of a dungeon that is rerolled by RegenerateRegion()
+struct DungeonRegion
+{
+    float mX{};
+    float mY{};
+    float mRadius{};
+
+    [[nodiscard]] bool Contains(float x, float y) const
+    {
+        const float dx = x - mX, dy = y - mY;
+        return dx * dx + dy * dy <= mRadius * mRadius;
+    }
+};
+
+struct RegenerationResult
+{
+    std::vector<std::uint32_t> mRooms{}; // Indices of the rerolled rooms, ascending
+    std::size_t mRemovedEdges = 0;
+    std::size_t mAddedEdges = 0;
+};
+
+namespace RegionDetail
+{
+    constexpr int SAMPLE_ATTEMPTS = 30; // Failed darts in a row before the spacing shrinks
+    constexpr float SPACING_SHRINK = 0.8f;
+    constexpr int AREA_SAMPLES = 64; // Per side of the grid that measures how much of the circle lies on the map
+
+    // The rectangle of mSizeX by mSizeY the Poisson sampling fills, or the ellipse inside it for mIsCircle
+    inline bool OnMap(const GenerationData& generationData, float x, float y)
+    {
+        if (generationData.mIsCircle) {
+            const float fx = x / generationData.mSizeX - 0.5f, fy = y / generationData.mSizeY - 0.5f;
+            return fx * fx + fy * fy <= 0.25f;
+        }
+        return x >= 0.0f && x <= generationData.mSizeX && y >= 0.0f && y <= generationData.mSizeY;
+    }
+
+    // Cell size of a PointGrid over extent for the given spacing, coarser where the spacing would need more cells
+    // than about four per point, so a tiny spacing cannot blow up the grid
+    inline float GridCellSize(float extent, float spacing, std::size_t points)
+    {
+        return std::max(spacing, extent / (2.0f * std::ceil(std::sqrt(static_cast<float>(points))) + 1.0f));
+    }
+
+    // The corridors of the rooms as PathHierarchy::Update() reads them
+    struct ConnectionGraph
+    {
+        const std::vector<DungeonVertex>& mVertices;
+
+        [[nodiscard]] std::span<const std::uint32_t> Neighbours(std::uint32_t room) const { return mVertices[room].mConnections; }
+    };
+
+    struct LocalEdge
+    {
+        std::uint32_t mA;
+        std::uint32_t mB;
+        float mLength;
+    };
+
+    // Candidate corridors between the local rooms: the Delaunay edges, or a chain along x when the rooms are collinear
+    inline std::vector<LocalEdge> CandidateEdges(const std::vector<float>& coords)
+    {
+        const auto count = static_cast<std::uint32_t>(coords.size() / 2);
+        const auto& length = [&](std::uint32_t a, std::uint32_t b)
+            {
+                return std::hypot(coords[2 * a] - coords[2 * b], coords[2 * a + 1] - coords[2 * b + 1]);
+            };
+
+        std::vector<LocalEdge> edges;
+        if (count >= 3) {
+            try {
+                const delaunator::Delaunator delaunay(coords);
+                edges.reserve(delaunay.halfedges.size() / 2 + 1);
+                for (std::size_t e = 0; e < delaunay.halfedges.size(); e++) {
+                    const std::size_t twin = delaunay.halfedges[e];
+                    if (twin == delaunator::INVALID_INDEX || e < twin) {
+                        const auto a = static_cast<std::uint32_t>(delaunay.triangles[e]);
+                        const auto b = static_cast<std::uint32_t>(delaunay.triangles[e % 3 == 2 ? e - 2 : e + 1]);
+                        edges.push_back({ a, b, length(a, b) });
+                    }
+                }
+                return edges;
+            }
+            catch (const std::runtime_error&) {
+            }
+        }
+
+        std::vector<std::uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+            {
+                return std::pair(coords[2 * a], coords[2 * a + 1]) < std::pair(coords[2 * b], coords[2 * b + 1]);
+            });
+        for (std::uint32_t i = 1; i < count; i++) {
+            edges.push_back({ order[i - 1], order[i], length(order[i - 1], order[i]) });
+        }
+        return edges;
+    }
+}
+
+// Lets RegenerateRegion() find the rooms in a circle and the corridors of a room without a pass over the dungeon.
+// Building it is one pass over the rooms and the corridors. It stays valid as long as the dungeon is only changed
+// by RegenerateRegion() calls that are given it, so keep one per dungeon when rerolling several regions.
+class RegionIndex
+{
+public:
+    static constexpr float ROOMS_PER_CELL = 4.0f;
+
+    RegionIndex() = default;
+
+    explicit RegionIndex(const Dungeon& dungeon)
+    {
+        const auto& vertices = dungeon.mVertices;
+        mRoomEdges.resize(vertices.size());
+        for (std::uint32_t i = 0; i < dungeon.mEdges.size(); i++) {
+            mRoomEdges[dungeon.mEdges[i].mNode1].push_back(i);
+            mRoomEdges[dungeon.mEdges[i].mNode2].push_back(i);
+        }
+        if (vertices.empty()) {
+            return;
+        }
+
+        float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+        mMinX = mMinY = std::numeric_limits<float>::max();
+        for (const auto& vertex : vertices) {
+            mMinX = std::min(mMinX, vertex.mPx);
+            mMinY = std::min(mMinY, vertex.mPy);
+            maxX = std::max(maxX, vertex.mPx);
+            maxY = std::max(maxY, vertex.mPy);
+        }
+        const float extent = std::max({ maxX - mMinX, maxY - mMinY, 1e-6f });
+        mCellSize = extent * std::sqrt(ROOMS_PER_CELL / static_cast<float>(vertices.size()));
+        mCellsX = static_cast<std::uint32_t>((maxX - mMinX) / mCellSize) + 1;
+        mCellsY = static_cast<std::uint32_t>((maxY - mMinY) / mCellSize) + 1;
+        mCells.resize(static_cast<std::size_t>(mCellsX) * mCellsY);
+        for (std::uint32_t room = 0; room < vertices.size(); room++) {
+            mCells[CellIndex(vertices[room].mPx, vertices[room].mPy)].push_back(room);
+        }
+    }
+
+    // Rooms with their centre in the circle, ascending
+    [[nodiscard]] std::vector<std::uint32_t> RoomsIn(const std::vector<DungeonVertex>& vertices, const DungeonRegion& region) const
+    {
+        std::vector<std::uint32_t> rooms;
+        if (mCells.empty()) {
+            return rooms;
+        }
+
+        const auto [minX, minY] = Cell(region.mX - region.mRadius, region.mY - region.mRadius);
+        const auto [maxX, maxY] = Cell(region.mX + region.mRadius, region.mY + region.mRadius);
+        for (std::uint32_t y = minY; y <= maxY; y++) {
+            for (std::uint32_t x = minX; x <= maxX; x++) {
+                for (std::uint32_t room : mCells[static_cast<std::size_t>(y) * mCellsX + x]) {
+                    if (region.Contains(vertices[room].mPx, vertices[room].mPy)) {
+                        rooms.push_back(room);
+                    }
+                }
+            }
+        }
+        std::sort(rooms.begin(), rooms.end());
+        return rooms;
+    }
+
+    // Indices into Dungeon::mEdges
+    [[nodiscard]] std::span<const std::uint32_t> Corridors(std::uint32_t room) const { return mRoomEdges[room]; }
+
+    void MoveRoom(std::uint32_t room, float fromX, float fromY, float toX, float toY)
+    {
+        const std::size_t from = CellIndex(fromX, fromY), to = CellIndex(toX, toY);
+        if (from != to) {
+            std::erase(mCells[from], room);
+            mCells[to].push_back(room);
+        }
+    }
+
+    // Writes added over the corridors at the ascending indices in removed. Extra corridors are appended, and when
+    // fewer come back the last corridors move into the remaining gaps. No other corridor changes its index.
+    void ReplaceEdges(std::vector<DungeonEdge>& edges, std::span<const std::uint32_t> removed, std::span<const DungeonEdge> added)
+    {
+        for (std::uint32_t index : removed) {
+            std::erase(mRoomEdges[edges[index].mNode1], index);
+            std::erase(mRoomEdges[edges[index].mNode2], index);
+        }
+
+        const std::size_t reused = std::min(removed.size(), added.size());
+        for (std::size_t i = 0; i < reused; i++) {
+            edges[removed[i]] = added[i];
+            Attach(removed[i], added[i]);
+        }
+        for (std::size_t i = reused; i < added.size(); i++) {
+            edges.push_back(added[i]);
+            Attach(static_cast<std::uint32_t>(edges.size() - 1), added[i]);
+        }
+
+        // From the back, so the last corridor is never a gap that is still to be filled
+        for (std::size_t i = removed.size(); i-- > reused;) {
+            const auto last = static_cast<std::uint32_t>(edges.size() - 1);
+            if (removed[i] != last) {
+                edges[removed[i]] = edges[last];
+                std::replace(mRoomEdges[edges[last].mNode1].begin(), mRoomEdges[edges[last].mNode1].end(), last, removed[i]);
+                std::replace(mRoomEdges[edges[last].mNode2].begin(), mRoomEdges[edges[last].mNode2].end(), last, removed[i]);
+            }
+            edges.pop_back();
+        }
+    }
+
+private:
+    // Positions outside of the grid go to the nearest border cell
+    [[nodiscard]] std::pair<std::uint32_t, std::uint32_t> Cell(float x, float y) const
+    {
+        return { static_cast<std::uint32_t>(std::clamp((x - mMinX) / mCellSize, 0.0f, static_cast<float>(mCellsX - 1))),
+            static_cast<std::uint32_t>(std::clamp((y - mMinY) / mCellSize, 0.0f, static_cast<float>(mCellsY - 1))) };
+    }
+
+    [[nodiscard]] std::size_t CellIndex(float x, float y) const
+    {
+        const auto [cellX, cellY] = Cell(x, y);
+        return static_cast<std::size_t>(cellY) * mCellsX + cellX;
+    }
+
+    void Attach(std::uint32_t index, const DungeonEdge& edge)
+    {
+        mRoomEdges[edge.mNode1].push_back(index);
+        mRoomEdges[edge.mNode2].push_back(index);
+    }
+
+    float mMinX = 0.0f;
+    float mMinY = 0.0f;
+    float mCellSize = 1.0f;
+    std::uint32_t mCellsX = 0;
+    std::uint32_t mCellsY = 0;
+    std::vector<std::vector<std::uint32_t>> mCells{}; // Rooms per cell
+    std::vector<std::vector<std::uint32_t>> mRoomEdges{}; // Corridors per room
+};
+
+// Rerolls the rooms inside the region and leaves every other room where it is with the same index.
+// As many rooms as were removed are resampled inside the circle, keeping the rooms around it at a distance,
+// and take over the removed indices. The new rooms and the outside rooms that had a corridor into the region are
+// triangulated on their own and reconnected with a Kruskal tree over the shortest corridors, which keeps every
+// room reachable that was reachable before. The loops lost with the removed corridors are added back from the
+// remaining local edges. New rooms take the difficulty of the closest removed room, START and BOSS move to the
+// closest new room and the other types are rerolled with mTreasureRoomPercentage.
+// New rooms only go where the circle overlaps the map of the GenerationData, see RegionDetail::OnMap().
+// The cost grows with the number of rooms in the region. Removed corridors are overwritten in Dungeon::mEdges, see
+// RegionIndex::ReplaceEdges() for the order. The navmesh is cleared as it no longer matches. The path hierarchy
+// is updated in the clusters around the region, see PathHierarchy::Update(). The counts of the metrics follow from the
+// changed rooms and corridors, only the hop distances take breadth first searches over the dungeon.
+// The dungeon cannot be reproduced from its GenerationData afterwards.
+inline RegenerationResult RegenerateRegion(Dungeon& dungeon, RegionIndex& index, const DungeonRegion& region, int seed)
+{
+    constexpr std::uint32_t INVALID = PointGrid::INVALID;
+
+    RegenerationResult result{};
+    auto& vertices = dungeon.mVertices;
+    const GenerationData& generationData = dungeon.mGenerationData;
+
+    result.mRooms = index.RoomsIn(vertices, region);
+    if (result.mRooms.empty()) {
+        return result;
+    }
+
+    const auto& removed = result.mRooms;
+    const auto count = static_cast<std::uint32_t>(removed.size());
+    const auto& inRegion = [&](std::uint32_t room) { return std::binary_search(removed.begin(), removed.end(), room); };
+
+    // Outside rooms the samples keep their distance to. The spacing is at most 1.25 radius, so this covers it.
+    std::vector<std::uint32_t> nearby = index.RoomsIn(vertices, { region.mX, region.mY, 2.25f * region.mRadius });
+    std::erase_if(nearby, inRegion);
+
+    // Outside rooms that lose a corridor, the new rooms have to reach all of them
+    std::vector<std::uint32_t> terminals;
+    for (std::uint32_t room : removed) {
+        for (std::uint32_t neighbour : vertices[room].mConnections) {
+            if (!inRegion(neighbour)) {
+                terminals.push_back(neighbour);
+            }
+        }
+    }
+    std::sort(terminals.begin(), terminals.end());
+    terminals.erase(std::unique(terminals.begin(), terminals.end()), terminals.end());
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    std::uniform_real_distribution<float> sizeDistribution(generationData.mMinVertexSize, generationData.mMaxVertexSize);
+
+    // Darts are thrown into the bounds of the circle on the map, and the spacing follows the area of that overlap
+    const float minX = std::max(region.mX - region.mRadius, 0.0f), maxX = std::min(region.mX + region.mRadius, generationData.mSizeX);
+    const float minY = std::max(region.mY - region.mRadius, 0.0f), maxY = std::min(region.mY + region.mRadius, generationData.mSizeY);
+    const auto& available = [&](float x, float y) { return region.Contains(x, y) && RegionDetail::OnMap(generationData, x, y); };
+    int overlap = 0;
+    for (int i = 0; i < RegionDetail::AREA_SAMPLES * RegionDetail::AREA_SAMPLES; i++) {
+        const float u = (static_cast<float>(i % RegionDetail::AREA_SAMPLES) + 0.5f) / RegionDetail::AREA_SAMPLES;
+        const float v = (static_cast<float>(i / RegionDetail::AREA_SAMPLES) + 0.5f) / RegionDetail::AREA_SAMPLES;
+        overlap += available(minX + u * (maxX - minX), minY + v * (maxY - minY));
+    }
+    const float area = std::max(maxX - minX, 0.0f) * std::max(maxY - minY, 0.0f)
+        * static_cast<float>(overlap) / static_cast<float>(RegionDetail::AREA_SAMPLES * RegionDetail::AREA_SAMPLES);
+
+    // Dart throwing with the spacing of a uniform spread, shrunk whenever the overlap seems full. Without any overlap
+    // the removed rooms stay where they are, then the spacing only sizes the grids below.
+    const float cellSize = overlap > 0 ? std::max(0.7f * std::sqrt(area / static_cast<float>(count)), 1e-6f)
+        : std::max(2.0f * region.mRadius / std::ceil(std::sqrt(static_cast<float>(count))), 1e-6f);
+    const float reach = region.mRadius + cellSize;
+    PointGrid sampleGrid(region.mX - reach, region.mY - reach, 2.0f * reach, RegionDetail::GridCellSize(2.0f * reach, cellSize, count + nearby.size()));
+    for (std::uint32_t room : nearby) {
+        const float dx = vertices[room].mPx - region.mX, dy = vertices[room].mPy - region.mY;
+        if (dx * dx + dy * dy <= reach * reach) {
+            sampleGrid.Insert(vertices[room].mPx, vertices[room].mPy);
+        }
+    }
+
+    std::vector<float> coords; // New rooms first, then the terminals
+    coords.reserve((count + terminals.size()) * 2);
+    float spacing = cellSize;
+    int failures = 0;
+    while (overlap > 0 && coords.size() < 2 * static_cast<std::size_t>(count)) {
+        const float x = minX + (maxX - minX) * unitDistribution(gen);
+        const float y = minY + (maxY - minY) * unitDistribution(gen);
+        if (!available(x, y)) {
+            continue;
+        }
+        if (sampleGrid.Free(x, y, spacing)) {
+            sampleGrid.Insert(x, y);
+            coords.push_back(x);
+            coords.push_back(y);
+            failures = 0;
+        }
+        else if (++failures == RegionDetail::SAMPLE_ATTEMPTS) {
+            spacing *= RegionDetail::SPACING_SHRINK;
+            failures = 0;
+        }
+    }
+    // A sliver of overlap the grid misses, the removed rooms are known to lie in it
+    if (overlap == 0) {
+        for (std::uint32_t room : removed) {
+            coords.push_back(vertices[room].mPx);
+            coords.push_back(vertices[room].mPy);
+        }
+    }
+    for (std::uint32_t room : terminals) {
+        coords.push_back(vertices[room].mPx);
+        coords.push_back(vertices[room].mPy);
+    }
+
+    const auto localCount = static_cast<std::uint32_t>(coords.size() / 2);
+    const auto& globalIndex = [&](std::uint32_t local) { return local < count ? removed[local] : terminals[local - count]; };
+
+    // Kruskal over the local triangulation, corridors between two terminals only where nothing else connects them
+    auto candidates = RegionDetail::CandidateEdges(coords);
+    std::sort(candidates.begin(), candidates.end(), [&](const RegionDetail::LocalEdge& a, const RegionDetail::LocalEdge& b)
+        {
+            const bool outsideA = a.mA >= count && a.mB >= count, outsideB = b.mA >= count && b.mB >= count;
+            return std::tie(outsideA, a.mLength, a.mA, a.mB) < std::tie(outsideB, b.mLength, b.mA, b.mB);
+        });
+
+    std::vector<std::uint32_t> roots(localCount);
+    std::iota(roots.begin(), roots.end(), 0u);
+    const auto& findRoot = [&](std::uint32_t x)
+        {
+            while (roots[x] != x) {
+                roots[x] = roots[roots[x]];
+                x = roots[x];
+            }
+            return x;
+        };
+
+    std::vector<DungeonEdge> newEdges;
+    std::vector<std::uint32_t> loopCandidates;
+    for (std::uint32_t i = 0; i < candidates.size(); i++) {
+        const auto& edge = candidates[i];
+        const std::uint32_t rootA = findRoot(edge.mA), rootB = findRoot(edge.mB);
+        if (rootA != rootB) {
+            roots[std::max(rootA, rootB)] = std::min(rootA, rootB);
+            // Terminals can already share a corridor outside the region
+            const auto& connections = vertices[globalIndex(edge.mA)].mConnections;
+            if (edge.mA < count || edge.mB < count || std::find(connections.begin(), connections.end(), globalIndex(edge.mB)) == connections.end()) {
+                newEdges.emplace_back(globalIndex(edge.mA), globalIndex(edge.mB));
+            }
+        }
+        else if (edge.mA < count || edge.mB < count) {
+            loopCandidates.push_back(i);
+        }
+    }
+
+    // Every corridor touching the region goes, the tree and as many loops as went missing come back in their place
+    std::vector<std::uint32_t> removedEdges;
+    for (std::uint32_t room : removed) {
+        const auto corridors = index.Corridors(room);
+        removedEdges.insert(removedEdges.end(), corridors.begin(), corridors.end());
+    }
+    std::sort(removedEdges.begin(), removedEdges.end());
+    removedEdges.erase(std::unique(removedEdges.begin(), removedEdges.end()), removedEdges.end());
+    result.mRemovedEdges = removedEdges.size();
+
+    const std::size_t loops = std::min(loopCandidates.size(), result.mRemovedEdges - std::min(result.mRemovedEdges, newEdges.size()));
+    for (std::size_t i = 0; i < loops; i++) {
+        std::uniform_int_distribution<std::size_t> pick(i, loopCandidates.size() - 1);
+        std::swap(loopCandidates[i], loopCandidates[pick(gen)]);
+        const auto& edge = candidates[loopCandidates[i]];
+        newEdges.emplace_back(globalIndex(edge.mA), globalIndex(edge.mB));
+    }
+    result.mAddedEdges = newEdges.size();
+
+    // Every room whose position or corridors change
+    std::vector<std::uint32_t> changed(removed.begin(), removed.end());
+    changed.insert(changed.end(), terminals.begin(), terminals.end());
+    std::sort(changed.begin(), changed.end());
+
+    // The metrics lose what the changed rooms and the removed corridors counted for, and get it back below
+    auto& metrics = dungeon.mMetrics;
+    const bool updateMetrics = generationData.mComputeMetrics && metrics.mRoomCount == vertices.size() && metrics.mComponents == 1;
+    const auto& corridorLength = [&](const DungeonEdge& edge)
+        {
+            const auto& a = vertices[edge.mNode1];
+            const auto& b = vertices[edge.mNode2];
+            return static_cast<double>(std::hypot(a.mPx - b.mPx, a.mPy - b.mPy));
+        };
+    double totalLength = static_cast<double>(metrics.mAverageCorridorLength) * metrics.mEdgeCount;
+    if (updateMetrics) {
+        for (std::uint32_t room : changed) {
+            const std::size_t degree = vertices[room].mConnections.size();
+            --metrics.mDegreeHistogram[degree];
+            metrics.mDeadEnds -= degree == 1;
+        }
+        for (std::uint32_t edge : removedEdges) {
+            totalLength -= corridorLength(dungeon.mEdges[edge]);
+        }
+    }
+
+    for (std::uint32_t room : terminals) {
+        std::erase_if(vertices[room].mConnections, inRegion);
+    }
+
+    // Content of the new rooms, looked up from the removed rooms before they are overwritten
+    const float contentCellSize = RegionDetail::GridCellSize(2.0f * region.mRadius, cellSize, count);
+    PointGrid oldGrid(region.mX - region.mRadius, region.mY - region.mRadius, 2.0f * region.mRadius, contentCellSize);
+    PointGrid newGrid(region.mX - region.mRadius, region.mY - region.mRadius, 2.0f * region.mRadius, contentCellSize);
+    std::uint32_t startRoom = INVALID, bossRoom = INVALID;
+    for (std::uint32_t i = 0; i < count; i++) {
+        oldGrid.Insert(vertices[removed[i]].mPx, vertices[removed[i]].mPy);
+        newGrid.Insert(coords[2 * i], coords[2 * i + 1]);
+    }
+    std::vector<float> difficulty(count);
+    for (std::uint32_t i = 0; i < count; i++) {
+        difficulty[i] = vertices[removed[oldGrid.Nearest(coords[2 * i], coords[2 * i + 1])]].mDifficulty;
+
+        const auto& vertex = vertices[removed[i]];
+        if (vertex.mType == RoomType::START) {
+            startRoom = newGrid.Nearest(vertex.mPx, vertex.mPy);
+        }
+        else if (vertex.mType == RoomType::BOSS) {
+            bossRoom = newGrid.Nearest(vertex.mPx, vertex.mPy);
+        }
+    }
+    // Both removed rooms can be closest to the same new room
+    if (startRoom != INVALID && startRoom == bossRoom && count > 1) {
+        bossRoom = (bossRoom + 1) % count;
+    }
+
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto& vertex = vertices[removed[i]];
+        index.MoveRoom(removed[i], vertex.mPx, vertex.mPy, coords[2 * i], coords[2 * i + 1]);
+        vertex.mPx = coords[2 * i];
+        vertex.mPy = coords[2 * i + 1];
+        vertex.mSize = sizeDistribution(gen);
+        vertex.mDifficulty = difficulty[i];
+        vertex.mConnections.clear();
+
+        const float roomType = unitDistribution(gen);
+        vertex.mType = generationData.mGenerateGameplayContent && roomType < generationData.mTreasureRoomPercentage ? RoomType::TREASURE : RoomType::ENEMY;
+    }
+    if (startRoom != INVALID) {
+        vertices[removed[startRoom]].mType = RoomType::START;
+    }
+    if (bossRoom != INVALID) {
+        vertices[removed[bossRoom]].mType = RoomType::BOSS;
+    }
+
+    for (const auto& edge : newEdges) {
+        vertices[edge.mNode1].mConnections.push_back(edge.mNode2);
+        vertices[edge.mNode2].mConnections.push_back(edge.mNode1);
+    }
+    index.ReplaceEdges(dungeon.mEdges, removedEdges, newEdges);
+
+    dungeon.mNavMesh = {};
+    const unsigned threadCount = vertices.size() >= PARALLEL_HIERARCHY_ROOMS ? std::thread::hardware_concurrency() : 1;
+    if (generationData.mBuildPathHierarchy && dungeon.mPathHierarchy.RoomCount() == vertices.size()) {
+        std::vector<float> positions;
+        positions.reserve(changed.size() * 2);
+        for (std::uint32_t room : changed) {
+            positions.push_back(vertices[room].mPx);
+            positions.push_back(vertices[room].mPy);
+        }
+        dungeon.mPathHierarchy.Update(changed, positions, RegionDetail::ConnectionGraph{ vertices }, threadCount);
+    }
+    else if (generationData.mBuildPathHierarchy) {
+        std::vector<float> positions;
+        positions.reserve(vertices.size() * 2);
+        for (const auto& vertex : vertices) {
+            positions.push_back(vertex.mPx);
+            positions.push_back(vertex.mPy);
+        }
+        dungeon.mPathHierarchy = PathHierarchy(positions, RoomGraph(vertices.size(), dungeon.mEdges), generationData.mClusterSize, threadCount);
+    }
+
+    if (updateMetrics) {
+        for (std::uint32_t room : changed) {
+            const std::size_t degree = vertices[room].mConnections.size();
+            if (degree >= metrics.mDegreeHistogram.size()) {
+                metrics.mDegreeHistogram.resize(degree + 1, 0);
+            }
+            ++metrics.mDegreeHistogram[degree];
+            metrics.mDeadEnds += degree == 1;
+        }
+        while (!metrics.mDegreeHistogram.empty() && metrics.mDegreeHistogram.back() == 0) {
+            metrics.mDegreeHistogram.pop_back();
+        }
+        for (const auto& edge : newEdges) {
+            totalLength += corridorLength(edge);
+        }
+
+        // The new rooms connect every terminal, so a connected dungeon stays connected
+        metrics.mEdgeCount = static_cast<std::uint32_t>(dungeon.mEdges.size());
+        metrics.mCycles = metrics.mEdgeCount + 1 - metrics.mRoomCount;
+        metrics.mAverageCorridorLength = metrics.mEdgeCount == 0 ? 0.0f : static_cast<float>(totalLength / metrics.mEdgeCount);
+
+        std::uint32_t start = UNREACHABLE_ROOM, boss = UNREACHABLE_ROOM;
+        for (std::uint32_t i = 0; i < vertices.size(); i++) {
+            if (vertices[i].mType == RoomType::START && start == UNREACHABLE_ROOM) {
+                start = i;
+            }
+            else if (vertices[i].mType == RoomType::BOSS && boss == UNREACHABLE_ROOM) {
+                boss = i;
+            }
+        }
+        ComputeHopMetrics(metrics, RoomGraph(vertices.size(), dungeon.mEdges), start, boss);
+    }
+    else if (generationData.mComputeMetrics) {
+        metrics = ComputeDungeonMetrics(dungeon);
+    }
+
+    return result;
+}
+
+// Builds a RegionIndex for the one call, which takes a pass over the dungeon
+inline RegenerationResult RegenerateRegion(Dungeon& dungeon, const DungeonRegion& region, int seed)
+{
+    RegionIndex index(dungeon);
+    return RegenerateRegion(dungeon, index, region, seed);
+}
+
+}
@@ -1,14 +1,35 @@
 #pragma once
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wall"
+#if defined(__clang__)
+	#pragma clang diagnostic push
+	#pragma clang diagnostic ignored "-Wall"
+#elif defined(_MSC_VER)
+	#pragma warning(push, 0)
+#endif
 #include "generationUtils/delaunator.hpp" // External library for delaunay triangulation
 #include "generationUtils/PoissonGenerator.hpp" // External library for poisson disk generation
-#pragma clang diagnostic pop
+#if defined(__clang__)
+	#pragma clang diagnostic pop
+#elif defined(_MSC_VER)
+	#pragma warning(pop)
+#endif
 
+#include "navMesh.hpp"
+#include "parallelFor.hpp"
+#include "pathHierarchy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <numeric>
 #include <random>
-#include <unordered_set>
-#include <queue>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <iostream>
 
@@ -19,6 +40,9 @@
 namespace DungeonGenerator
 {
 
+// Bumped whenever the output of Generate() changes for the same GenerationData
+constexpr std::uint32_t LIBRARY_VERSION = 3;
+
 struct VertexSizeBounds {
     float mMin = 1.0f;
     float mMax = 1.0f;
@@ -29,6 +53,22 @@ struct DungeonSize {
     float mSizeY = 100.0f;
 };
 
+// How START, BOSS and TREASURE rooms are picked when gameplay content is generated
+enum class ContentPlacement : std::uint8_t
+{
+    RANDOM, // Treasure is a coin flip per room, START and BOSS are the first and last room
+    GRAPH, // Placed from the final connectivity, see PlaceContent()
+};
+
+// How the MST weighs the triangulation edges, the lightest edges become corridors
+enum class EdgeWeightMode : std::uint8_t
+{
+    RANDOM, // Uniform random, ignores the geometry
+    EUCLIDEAN, // Distance between the room centres
+    SIZE_SCALED, // Distance divided by the summed room sizes, corridors prefer big rooms
+    JITTERED, // Distance times 1 + mWeightJitter * uniform [0, 1)
+};
+
 struct GenerationData
 {
     GenerationData() = default;
@@ -59,9 +99,23 @@ struct GenerationData
 
     bool mGenerateGameplayContent = false;
     float mTreasureRoomPercentage = 0.1f;
+    ContentPlacement mContentPlacement = ContentPlacement::GRAPH;
+
+    EdgeWeightMode mEdgeWeightMode = EdgeWeightMode::RANDOM;
+    float mWeightJitter = 0.25f; // Only used by EdgeWeightMode::JITTERED
+
+    bool mBuildNavMesh = false; // Keep the triangulation as a NavMesh, see GenerationStage::NAVMESH
+
+    bool mBuildPathHierarchy = false; // Cluster the rooms for long range path queries, see PathHierarchy
+    float mClusterSize = 0.0f; // Side of a cluster, 0 picks one with about PathHierarchy::DEFAULT_CLUSTER_ROOMS rooms
+
+    bool mComputeMetrics = false; // Measure the dungeon while it is generated, see GenerationStage::METRICS
+
+    // When adding fields, also add them to VisitGenerationData() in dungeonCache.hpp
+    bool operator==(const GenerationData&) const = default;
 };
 
-enum class RoomType
+enum class RoomType : std::uint8_t
 {
     START,
     BOSS,
@@ -70,6 +124,12 @@ enum class RoomType
     NUM_TYPES,
 };
 
+inline const char* RoomTypeName(RoomType type)
+{
+    constexpr const char* names[] = { "start", "boss", "enemy", "treasure" };
+    return type < RoomType::NUM_TYPES ? names[static_cast<int>(type)] : "unknown";
+}
+
 struct DungeonVertex
 {
     DungeonVertex() = default;
@@ -80,6 +140,7 @@ struct DungeonVertex
     float mPx{};
     float mPy{};
     float mSize{};
+    float mDifficulty{}; // Distance from START relative to the farthest room, 0 without gameplay content
     std::vector<std::uint32_t> mConnections; // Indices to connected vertices
     RoomType mType { RoomType::ENEMY };
 };
@@ -95,26 +156,611 @@ struct DungeonEdge
     std::uint32_t mNode2{};
 };
 
+constexpr std::uint32_t UNREACHABLE_ROOM = std::numeric_limits<std::uint32_t>::max();
+
+// Estimated bookkeeping the heap allocator adds to every allocation
+constexpr std::size_t HEAP_BLOCK_OVERHEAD = 16;
+
+// Bytes used by a dungeon, split per component
+struct MemoryReport
+{
+    std::size_t mVertices = 0; // Vertex array, including the vector headers of the connection lists
+    std::size_t mConnections = 0; // Per vertex connection lists
+    std::size_t mEdges = 0;
+    std::size_t mNavMesh = 0;
+    std::size_t mPathHierarchy = 0;
+    std::size_t mAllocatorOverhead = 0; // Estimated, HEAP_BLOCK_OVERHEAD per live allocation
+    std::size_t mRoomCount = 0;
+
+    [[nodiscard]] std::size_t Total() const { return mVertices + mConnections + mEdges + mNavMesh + mPathHierarchy + mAllocatorOverhead; }
+    [[nodiscard]] double BytesPerRoom() const { return mRoomCount == 0 ? 0.0 : static_cast<double>(Total()) / static_cast<double>(mRoomCount); }
+};
+
+// Shape of a finished dungeon for tuning the generation parameters, see ComputeDungeonMetrics()
+struct DungeonMetrics
+{
+    std::uint32_t mRoomCount = 0;
+    std::uint32_t mEdgeCount = 0;
+    std::uint32_t mComponents = 0; // Connected groups of rooms, 1 for every generated dungeon
+    std::uint32_t mCycles = 0; // Independent cycles, E - V + mComponents
+    std::uint32_t mDiameter = 0; // Hops, double sweep estimate: exact on trees, a lower bound otherwise
+    std::uint32_t mDeadEnds = 0; // Rooms with one corridor
+    std::vector<std::uint32_t> mDegreeHistogram{}; // Rooms per number of corridors
+    float mAverageCorridorLength = 0.0f; // Between the room centres
+    std::uint32_t mStartBossDistance = UNREACHABLE_ROOM; // Hops, UNREACHABLE_ROOM without START and BOSS or when they are disconnected
+
+    [[nodiscard]] float DeadEndRatio() const { return mRoomCount == 0 ? 0.0f : static_cast<float>(mDeadEnds) / static_cast<float>(mRoomCount); }
+
+    bool operator==(const DungeonMetrics&) const = default;
+};
+
+// Room positions owned by the caller. Generating from them skips the Poisson sampling and the triangulation
+// reads them in place, so they have to outlive the generation.
+struct PointSet
+{
+    delaunator::point_view mPoints{};
+    std::span<const float> mSizes{}; // Optional, drawn between the size bounds of the GenerationData when empty
+
+    // x, y per room
+    static PointSet Interleaved(std::span<const float> coords, std::span<const float> sizes = {})
+    {
+        return { delaunator::point_view(coords.data(), coords.empty() ? nullptr : coords.data() + 1, 2, coords.size() / 2), sizes };
+    }
+
+    // Separate x and y arrays of the same length
+    static PointSet Separate(std::span<const float> xs, std::span<const float> ys, std::span<const float> sizes = {})
+    {
+        if (xs.size() != ys.size()) {
+            throw std::invalid_argument("x and y coordinates differ in length");
+        }
+        return { delaunator::point_view(xs.data(), ys.data(), 1, xs.size()), sizes };
+    }
+
+    [[nodiscard]] std::size_t Size() const { return mPoints.size(); }
+};
+
 class Dungeon
 {
 public:
     std::vector<DungeonVertex> mVertices{};
     std::vector<DungeonEdge> mEdges{};
+    NavMesh mNavMesh{}; // Empty unless GenerationData::mBuildNavMesh is set
+    PathHierarchy mPathHierarchy{}; // Empty unless GenerationData::mBuildPathHierarchy is set
+    DungeonMetrics mMetrics{}; // Empty unless GenerationData::mComputeMetrics is set
 
     GenerationData mGenerationData{};
 
+    Dungeon() = default;
+
     explicit Dungeon(const GenerationData &generationData)
         : mGenerationData(generationData)
     {
-        Generate();
+        Generate(nullptr);
+    }
+
+    // Rooms at the given points instead of Poisson sampled ones, mNrVertices is ignored
+    Dungeon(const GenerationData &generationData, const PointSet& points)
+        : mGenerationData(generationData)
+    {
+        Generate(&points);
+    }
+
+    [[nodiscard]] MemoryReport MemoryUsage() const
+    {
+        MemoryReport usage{};
+        usage.mRoomCount = mVertices.size();
+        usage.mVertices = sizeof(Dungeon) + mVertices.capacity() * sizeof(DungeonVertex);
+        usage.mEdges = mEdges.capacity() * sizeof(DungeonEdge);
+        usage.mNavMesh = mNavMesh.MemoryUsage();
+        usage.mPathHierarchy = mPathHierarchy.MemoryUsage();
+        usage.mAllocatorOverhead = (mVertices.capacity() > 0) * HEAP_BLOCK_OVERHEAD + (mEdges.capacity() > 0) * HEAP_BLOCK_OVERHEAD;
+
+        for (const auto& vertex : mVertices) {
+            usage.mConnections += vertex.mConnections.capacity() * sizeof(std::uint32_t);
+            usage.mAllocatorOverhead += (vertex.mConnections.capacity() > 0) * HEAP_BLOCK_OVERHEAD;
+        }
+
+        return usage;
     }
 
 private:
-    void Generate();
+    void Generate(const PointSet* points);
 };
 
 	static_assert(sizeof(uint32_t) == sizeof(unsigned int));
 
+// Receives the generated dungeon while the pipeline runs, so the output can be written straight into caller memory.
+// SetVertexCount is called once before any vertex, type or edge is written.
+// Sinks may also implement SetDifficulty(index, float), it is called once per vertex after the loops are added.
+// Sinks may implement SetNavMesh(NavMesh&&), it is called once when GenerationData::mBuildNavMesh is set.
+// Sinks may implement SetPathHierarchy(PathHierarchy&&), likewise for GenerationData::mBuildPathHierarchy.
+// Sinks may implement SetMetrics(DungeonMetrics&&), likewise for GenerationData::mComputeMetrics.
+// Sinks may implement StageCompleted(GenerationStage), it is called right after each stage finishes.
+// When it returns a bool, false stops the generation there and sets GenerationResult::mAborted.
+// Sinks may implement ThreadCount() to limit the threads of the stages that split their work, for dungeons generated
+// next to each other. Without it those stages use every hardware thread once the dungeon is large enough.
+template <typename T>
+concept GenerationSink = requires(T sink, std::uint32_t index, float value, RoomType type)
+{
+    sink.SetVertexCount(index);
+    sink.SetVertex(index, value, value, value);
+    sink.SetType(index, type);
+    sink.AddEdge(index, index);
+};
+
+// Pipeline stages in execution order
+enum class GenerationStage
+{
+    POISSON,
+    COORDINATES,
+    TRIANGULATION,
+    MST_INIT,
+    MST,
+    ROOM_TYPES,
+    LOOPS,
+    CONTENT,
+    NAVMESH, // Only does work when GenerationData::mBuildNavMesh is set
+    HIERARCHY, // Only does work when GenerationData::mBuildPathHierarchy is set
+    METRICS, // Only does work when GenerationData::mComputeMetrics is set
+    NUM_STAGES,
+};
+
+inline const char* StageName(GenerationStage stage)
+{
+    constexpr const char* names[] = { "poisson", "coordinates", "triangulation", "mst_init", "mst", "room_types", "loops", "content", "navmesh", "hierarchy", "metrics" };
+    return stage < GenerationStage::NUM_STAGES ? names[static_cast<int>(stage)] : "unknown";
+}
+
+// Upper bounds for the output of a generation, used to size caller buffers
+struct BufferSizes
+{
+    std::size_t mVertices = 0;
+    std::size_t mEdges = 0;
+};
+
+// For dungeons generated from a PointSet of roomCount points
+inline BufferSizes RequiredBufferSizes(const GenerationData& generationData, std::size_t roomCount)
+{
+    return { roomCount, roomCount - 1 + static_cast<std::size_t>(std::max(generationData.mNrLoops, 0)) };
+}
+
+inline BufferSizes RequiredBufferSizes(const GenerationData& generationData)
+{
+    return RequiredBufferSizes(generationData, static_cast<std::size_t>(generationData.mNrVertices));
+}
+
+struct GenerationResult
+{
+    std::size_t mVertexCount = 0;
+    std::size_t mEdgeCount = 0;
+    bool mAborted = false; // The sink stopped the generation after a stage, the output is incomplete
+};
+
+// Caller owned output, sized with RequiredBufferSizes()
+struct GenerationBuffers
+{
+    std::span<float> mPositions{}; // Interleaved x, y
+    std::span<float> mSizes{};
+    std::span<RoomType> mTypes{}; // Optional
+    std::span<float> mDifficulty{}; // Optional
+    std::span<DungeonEdge> mEdges{};
+};
+
+template <GenerationSink Sink>
+GenerationResult GenerateInto(const GenerationData& generationData, Sink& sink);
+
+// Rooms at the caller's points, throws std::invalid_argument for fewer than 3 points
+template <GenerationSink Sink>
+GenerationResult GenerateInto(const GenerationData& generationData, const PointSet& points, Sink& sink);
+
+// Writes into GenerationBuffers, throws std::length_error when they are too small
+struct BufferSink
+{
+    const GenerationBuffers& mBuffers;
+    std::size_t mEdgeCount = 0;
+
+    void SetVertexCount(std::uint32_t count) const
+    {
+        if (mBuffers.mPositions.size() < count * 2ull || mBuffers.mSizes.size() < count
+            || (!mBuffers.mTypes.empty() && mBuffers.mTypes.size() < count)
+            || (!mBuffers.mDifficulty.empty() && mBuffers.mDifficulty.size() < count)) {
+            throw std::length_error("Vertex buffers are too small for the generated dungeon");
+        }
+    }
+
+    void SetVertex(std::uint32_t index, float x, float y, float size) const
+    {
+        mBuffers.mPositions[index * 2ull] = x;
+        mBuffers.mPositions[index * 2ull + 1] = y;
+        mBuffers.mSizes[index] = size;
+    }
+
+    void SetType(std::uint32_t index, RoomType type) const
+    {
+        if (!mBuffers.mTypes.empty()) {
+            mBuffers.mTypes[index] = type;
+        }
+    }
+
+    void SetDifficulty(std::uint32_t index, float difficulty) const
+    {
+        if (!mBuffers.mDifficulty.empty()) {
+            mBuffers.mDifficulty[index] = difficulty;
+        }
+    }
+
+    void AddEdge(std::uint32_t a, std::uint32_t b)
+    {
+        if (mEdgeCount == mBuffers.mEdges.size()) {
+            throw std::length_error("Edge buffer is too small for the generated dungeon");
+        }
+        mBuffers.mEdges[mEdgeCount++] = DungeonEdge(a, b);
+    }
+};
+
+// Writes the dungeon into the given buffers, throws std::length_error when they are too small
+inline GenerationResult GenerateInto(const GenerationData& generationData, const GenerationBuffers& buffers)
+{
+	BufferSink sink{ buffers };
+	return GenerateInto(generationData, sink);
+}
+
+inline GenerationResult GenerateInto(const GenerationData& generationData, const PointSet& points, const GenerationBuffers& buffers)
+{
+	BufferSink sink{ buffers };
+	return GenerateInto(generationData, points, sink);
+}
+
+// Connectivity of a finished dungeon in compressed sparse row form
+class RoomGraph
+{
+public:
+    RoomGraph() = default;
+    RoomGraph(std::size_t roomCount, std::span<const DungeonEdge> edges)
+        : mOffsets(roomCount + 1, 0), mNeighbours(edges.size() * 2)
+    {
+        for (const auto& edge : edges) {
+            ++mOffsets[edge.mNode1 + 1];
+            ++mOffsets[edge.mNode2 + 1];
+        }
+        for (std::size_t i = 0; i < roomCount; i++) {
+            mOffsets[i + 1] += mOffsets[i];
+        }
+
+        std::vector<std::uint32_t> next(mOffsets.begin(), mOffsets.end() - 1);
+        for (const auto& edge : edges) {
+            mNeighbours[next[edge.mNode1]++] = edge.mNode2;
+            mNeighbours[next[edge.mNode2]++] = edge.mNode1;
+        }
+    }
+
+    [[nodiscard]] std::uint32_t RoomCount() const { return mOffsets.empty() ? 0 : static_cast<std::uint32_t>(mOffsets.size() - 1); }
+    [[nodiscard]] std::uint32_t Degree(std::uint32_t room) const { return mOffsets[room + 1] - mOffsets[room]; }
+    [[nodiscard]] std::span<const std::uint32_t> Neighbours(std::uint32_t room) const
+    {
+        return std::span<const std::uint32_t>(mNeighbours).subspan(mOffsets[room], Degree(room));
+    }
+
+private:
+    std::vector<std::uint32_t> mOffsets{};
+    std::vector<std::uint32_t> mNeighbours{};
+};
+
+struct RoomMetrics
+{
+    std::uint32_t mStart = 0;
+    std::uint32_t mBoss = 0;
+    std::vector<std::uint32_t> mDistance{}; // Hops from START, UNREACHABLE_ROOM when disconnected
+    std::uint32_t mMaxDistance = 0;
+    std::uint32_t mFarthest = 0; // Lowest room at mMaxDistance
+    std::uint32_t mPeakCount = 0; // Rooms other than START and BOSS for which IsPeak() holds
+
+    // No neighbour lies farther from START: dead ends and the far sides of loops
+    [[nodiscard]] bool IsPeak(const RoomGraph& graph, std::uint32_t room) const
+    {
+        if (mDistance[room] == UNREACHABLE_ROOM) {
+            return false;
+        }
+        for (std::uint32_t neighbour : graph.Neighbours(room)) {
+            if (mDistance[neighbour] > mDistance[room]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Breadth first distances from start, mBoss and mPeakCount are left for the caller
+inline RoomMetrics ComputeRoomMetrics(const RoomGraph& graph, std::uint32_t start)
+{
+    RoomMetrics metrics;
+    metrics.mStart = start;
+    metrics.mDistance.assign(graph.RoomCount(), UNREACHABLE_ROOM);
+    if (graph.RoomCount() == 0) {
+        return metrics;
+    }
+
+    std::vector<std::uint32_t> queue;
+    queue.reserve(graph.RoomCount());
+    queue.push_back(start);
+    metrics.mDistance[start] = 0;
+
+    for (std::size_t head = 0; head < queue.size(); head++) {
+        const std::uint32_t room = queue[head];
+        for (std::uint32_t neighbour : graph.Neighbours(room)) {
+            if (metrics.mDistance[neighbour] == UNREACHABLE_ROOM) {
+                metrics.mDistance[neighbour] = metrics.mDistance[room] + 1;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+
+    metrics.mFarthest = start;
+    for (std::uint32_t room = 0; room < graph.RoomCount(); room++) {
+        if (metrics.mDistance[room] != UNREACHABLE_ROOM && metrics.mDistance[room] > metrics.mMaxDistance) {
+            metrics.mMaxDistance = metrics.mDistance[room];
+            metrics.mFarthest = room;
+        }
+    }
+
+    return metrics;
+}
+
+// Uniform value in [0, 1) that only depends on the seed and the room, so rooms can be evaluated in any order
+inline float RoomRandom(std::uint64_t seed, std::uint32_t room)
+{
+    std::uint64_t x = seed * 0x9E3779B97F4A7C15ull + room;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return static_cast<float>(x >> 40) * (1.0f / 16777216.0f);
+}
+
+struct ContentContext
+{
+    const RoomGraph& mGraph;
+    const RoomMetrics& mMetrics;
+    const GenerationData& mGenerationData;
+    std::span<RoomType> mTypes;
+    std::span<float> mDifficulty;
+};
+
+// Evaluated once per room, possibly on several threads at once, so a rule may only write the entries of its room.
+// Rules run in order, START and BOSS are assigned after all rules.
+using ContentRule = std::function<void(const ContentContext&, std::uint32_t room)>;
+
+// Difficulty ramps linearly with the distance from START
+inline void DifficultyRule(const ContentContext& context, std::uint32_t room)
+{
+    const auto& metrics = context.mMetrics;
+    const std::uint32_t distance = metrics.mDistance[room];
+    context.mDifficulty[room] = distance == UNREACHABLE_ROOM || metrics.mMaxDistance == 0
+        ? 1.0f : static_cast<float>(distance) / static_cast<float>(metrics.mMaxDistance);
+}
+
+// Treasure goes on peaks, scaled so about mTreasureRoomPercentage of all rooms hold treasure when there are enough peaks
+inline void TreasureRule(const ContentContext& context, std::uint32_t room)
+{
+    const auto& metrics = context.mMetrics;
+    if (metrics.mPeakCount == 0 || room == metrics.mStart || room == metrics.mBoss || !metrics.IsPeak(context.mGraph, room)) {
+        return;
+    }
+
+    const float chance = context.mGenerationData.mTreasureRoomPercentage * static_cast<float>(context.mGraph.RoomCount())
+        / static_cast<float>(metrics.mPeakCount);
+    if (RoomRandom(static_cast<std::uint64_t>(context.mGenerationData.mSeed), room) < chance) {
+        context.mTypes[room] = RoomType::TREASURE;
+    }
+}
+
+inline std::vector<ContentRule> DefaultContentRules()
+{
+    return { DifficultyRule, TreasureRule };
+}
+
+// Puts BOSS on the leaf in [first, last) farthest from START, or on the farthest room there when it has no leaf
+inline void PlaceBoss(const RoomGraph& graph, RoomMetrics& metrics, std::uint32_t first, std::uint32_t last)
+{
+    std::uint32_t leafDistance = 0, roomDistance = 0;
+    metrics.mBoss = UNREACHABLE_ROOM;
+    std::uint32_t farthest = first;
+    for (std::uint32_t room = first; room < last; room++) {
+        const std::uint32_t distance = metrics.mDistance[room];
+        if (room == metrics.mStart || distance == UNREACHABLE_ROOM) {
+            continue;
+        }
+        if (distance > roomDistance) {
+            roomDistance = distance;
+            farthest = room;
+        }
+        if (graph.Degree(room) == 1 && distance > leafDistance) {
+            leafDistance = distance;
+            metrics.mBoss = room;
+        }
+    }
+    if (metrics.mBoss == UNREACHABLE_ROOM) {
+        metrics.mBoss = farthest;
+    }
+}
+
+// Runs the rules over every room once START, BOSS and the distances from START are in metrics, then marks START and BOSS
+inline void ApplyContentRules(const RoomGraph& graph, const GenerationData& generationData, RoomMetrics& metrics, std::span<RoomType> types,
+    std::span<float> difficulty, std::span<const ContentRule> rules, unsigned threadCount = 1)
+{
+    metrics.mPeakCount = 0;
+    for (std::uint32_t room = 0; room < graph.RoomCount(); room++) {
+        metrics.mPeakCount += room != metrics.mStart && room != metrics.mBoss && metrics.IsPeak(graph, room);
+    }
+
+    const ContentContext context{ graph, metrics, generationData, types, difficulty };
+    ParallelFor(graph.RoomCount(), threadCount, [&](std::size_t begin, std::size_t end)
+        {
+            for (auto room = static_cast<std::uint32_t>(begin); room < end; room++) {
+                types[room] = RoomType::ENEMY;
+                difficulty[room] = 0.0f;
+                for (const auto& rule : rules) {
+                    rule(context, room);
+                }
+            }
+        });
+
+    types[metrics.mStart] = RoomType::START;
+    types[metrics.mBoss] = RoomType::BOSS;
+}
+
+// Picks START at the periphery of the dungeon and BOSS on the leaf farthest from it, then runs the rules over every room.
+// Every pass is linear in the size of the graph, the output does not depend on the number of threads.
+inline RoomMetrics PlaceContent(const RoomGraph& graph, const GenerationData& generationData, std::span<RoomType> types,
+    std::span<float> difficulty, std::span<const ContentRule> rules, unsigned threadCount = 1)
+{
+    if (graph.RoomCount() == 0) {
+        return {};
+    }
+
+    // The room farthest from any room is an end of a long shortest path
+    RoomMetrics metrics = ComputeRoomMetrics(graph, ComputeRoomMetrics(graph, 0).mFarthest);
+    PlaceBoss(graph, metrics, 0, graph.RoomCount());
+    ApplyContentRules(graph, generationData, metrics, types, difficulty, rules, threadCount);
+    return metrics;
+}
+
+// The two breadth first searches of ComputeDungeonMetrics(), for mDiameter and mStartBossDistance
+inline void ComputeHopMetrics(DungeonMetrics& metrics, const RoomGraph& graph, std::uint32_t start = UNREACHABLE_ROOM, std::uint32_t boss = UNREACHABLE_ROOM)
+{
+    metrics.mDiameter = 0;
+    metrics.mStartBossDistance = UNREACHABLE_ROOM;
+    if (graph.RoomCount() == 0) {
+        return;
+    }
+
+    const RoomMetrics fromStart = ComputeRoomMetrics(graph, start < graph.RoomCount() ? start : 0);
+    if (start < graph.RoomCount() && boss < graph.RoomCount()) {
+        metrics.mStartBossDistance = fromStart.mDistance[boss];
+    }
+    metrics.mDiameter = ComputeRoomMetrics(graph, fromStart.mFarthest).mMaxDistance;
+}
+
+// Linear in the size of the dungeon: one pass labels the components and two breadth first searches estimate the
+// diameter of the component of START, or of room 0 without one. The first search also yields the START to BOSS distance.
+// positions holds x, y per room, start and boss are UNREACHABLE_ROOM when the dungeon has none.
+inline DungeonMetrics ComputeDungeonMetrics(const RoomGraph& graph, std::span<const DungeonEdge> edges, std::span<const float> positions,
+    std::uint32_t start = UNREACHABLE_ROOM, std::uint32_t boss = UNREACHABLE_ROOM)
+{
+    DungeonMetrics metrics;
+    metrics.mRoomCount = graph.RoomCount();
+    metrics.mEdgeCount = static_cast<std::uint32_t>(edges.size());
+    if (metrics.mRoomCount == 0) {
+        return metrics;
+    }
+
+    std::vector<bool> visited(metrics.mRoomCount, false);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(metrics.mRoomCount);
+    for (std::uint32_t room = 0; room < metrics.mRoomCount; room++) {
+        const std::uint32_t degree = graph.Degree(room);
+        if (degree >= metrics.mDegreeHistogram.size()) {
+            metrics.mDegreeHistogram.resize(degree + 1, 0);
+        }
+        ++metrics.mDegreeHistogram[degree];
+        metrics.mDeadEnds += degree == 1;
+
+        if (visited[room]) {
+            continue;
+        }
+        ++metrics.mComponents;
+        queue.clear();
+        queue.push_back(room);
+        visited[room] = true;
+        for (std::size_t head = 0; head < queue.size(); head++) {
+            for (std::uint32_t neighbour : graph.Neighbours(queue[head])) {
+                if (!visited[neighbour]) {
+                    visited[neighbour] = true;
+                    queue.push_back(neighbour);
+                }
+            }
+        }
+    }
+    metrics.mCycles = metrics.mEdgeCount + metrics.mComponents - metrics.mRoomCount;
+
+    ComputeHopMetrics(metrics, graph, start, boss);
+
+    double length = 0.0;
+    for (const auto& edge : edges) {
+        length += std::hypot(positions[2 * edge.mNode1] - positions[2 * edge.mNode2], positions[2 * edge.mNode1 + 1] - positions[2 * edge.mNode2 + 1]);
+    }
+    metrics.mAverageCorridorLength = edges.empty() ? 0.0f : static_cast<float>(length / static_cast<double>(edges.size()));
+
+    return metrics;
+}
+
+// START and BOSS are looked up by type
+inline DungeonMetrics ComputeDungeonMetrics(const Dungeon& dungeon)
+{
+    std::vector<float> positions;
+    positions.reserve(dungeon.mVertices.size() * 2);
+    std::uint32_t start = UNREACHABLE_ROOM, boss = UNREACHABLE_ROOM;
+    for (std::uint32_t i = 0; i < dungeon.mVertices.size(); i++) {
+        const auto& vertex = dungeon.mVertices[i];
+        positions.push_back(vertex.mPx);
+        positions.push_back(vertex.mPy);
+        if (vertex.mType == RoomType::START && start == UNREACHABLE_ROOM) {
+            start = i;
+        }
+        else if (vertex.mType == RoomType::BOSS && boss == UNREACHABLE_ROOM) {
+            boss = i;
+        }
+    }
+    return ComputeDungeonMetrics(RoomGraph(dungeon.mVertices.size(), dungeon.mEdges), dungeon.mEdges, positions, start, boss);
+}
+
+// Stable LSD radix sort on 8 bit digits, returns the indices of the keys in ascending order.
+// Digits that are the same for every key are skipped.
+inline std::vector<std::uint32_t> RadixSortIndices(std::span<const std::uint32_t> keys)
+{
+    constexpr std::uint32_t DIGIT_BITS = 8;
+    constexpr std::uint32_t DIGIT_COUNT = 32 / DIGIT_BITS;
+    constexpr std::uint32_t BUCKETS = 1u << DIGIT_BITS;
+
+    std::vector<std::uint32_t> order(keys.size()), scratch(keys.size());
+    std::iota(order.begin(), order.end(), 0u);
+    if (keys.empty()) {
+        return order;
+    }
+
+    // Histograms of every digit in one pass over the keys
+    std::array<std::array<std::uint32_t, BUCKETS>, DIGIT_COUNT> counts{};
+    for (std::uint32_t key : keys) {
+        for (std::uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+            ++counts[digit][(key >> (digit * DIGIT_BITS)) & (BUCKETS - 1)];
+        }
+    }
+
+    for (std::uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+        const std::uint32_t shift = digit * DIGIT_BITS;
+        auto& offsets = counts[digit];
+        if (offsets[(keys[0] >> shift) & (BUCKETS - 1)] == keys.size()) {
+            continue;
+        }
+
+        std::uint32_t sum = 0;
+        for (auto& offset : offsets) {
+            sum += std::exchange(offset, sum);
+        }
+        for (std::uint32_t index : order) {
+            scratch[offsets[(keys[index] >> shift) & (BUCKETS - 1)]++] = index;
+        }
+        order.swap(scratch);
+    }
+
+    return order;
+}
+
+// Dungeons with fewer rooms place their content on the generating thread
+constexpr std::uint32_t PARALLEL_CONTENT_ROOMS = 1u << 16;
+
+// Dungeons with fewer rooms build their path hierarchy on the generating thread
+constexpr std::uint32_t PARALLEL_HIERARCHY_ROOMS = 1u << 14;
+
 #ifdef LOGGING
     using Timer = std::chrono::high_resolution_clock;
 
@@ -123,90 +769,266 @@ private:
     }
 #endif
 
-    void Dungeon::Generate() {
+// Fills a Dungeon, its mConnections are kept up to date with every edge
+struct DungeonSink
+{
+    Dungeon& mDungeon;
+
+    void SetVertexCount(std::uint32_t count) const
+    {
+        mDungeon.mVertices.resize(count);
+        mDungeon.mEdges.reserve(RequiredBufferSizes(mDungeon.mGenerationData, count).mEdges);
+    }
+
+    void SetVertex(std::uint32_t index, float x, float y, float size) const
+    {
+        auto& vertex = mDungeon.mVertices[index];
+        vertex.mPx = x;
+        vertex.mPy = y;
+        vertex.mSize = size;
+    }
+
+    void SetType(std::uint32_t index, RoomType type) const
+    {
+        mDungeon.mVertices[index].mType = type;
+    }
+
+    void SetDifficulty(std::uint32_t index, float difficulty) const
+    {
+        mDungeon.mVertices[index].mDifficulty = difficulty;
+    }
+
+    void SetNavMesh(NavMesh&& navMesh) const
+    {
+        mDungeon.mNavMesh = std::move(navMesh);
+    }
+
+    void SetPathHierarchy(PathHierarchy&& pathHierarchy) const
+    {
+        mDungeon.mPathHierarchy = std::move(pathHierarchy);
+    }
+
+    void SetMetrics(DungeonMetrics&& metrics) const
+    {
+        mDungeon.mMetrics = std::move(metrics);
+    }
+
+    void AddEdge(std::uint32_t a, std::uint32_t b) const
+    {
+        mDungeon.mEdges.emplace_back(a, b);
+        mDungeon.mVertices[a].mConnections.push_back(b);
+        mDungeon.mVertices[b].mConnections.push_back(a);
+    }
+};
+
+    inline void Dungeon::Generate(const PointSet* points) {
+
+	mVertices.clear();
+	mEdges.clear();
+	mNavMesh = {};
+	mPathHierarchy = {};
+	mMetrics = {};
+
+	DungeonSink sink{ *this };
+	if (points) {
+		GenerateInto(mGenerationData, *points, sink);
+	}
+	else {
+		GenerateInto(mGenerationData, sink);
+	}
+}
+
+template <GenerationSink Sink>
+GenerationResult GenerateInto(const GenerationData& generationData, Sink& sink) {
 
 #ifdef LOGGING
 	const auto start = Timer::now();
-	auto running = Timer::now();
-	std::cout << "Dungeon generation started" << std::endl;
 #endif
 
-	std::mt19937 gen(mGenerationData.mSeed);
-	std::uniform_real_distribution<float> sizeDistribution(mGenerationData.mMinVertexSize, mGenerationData.mMaxVertexSize);
-	std::uniform_int<std::uint32_t> weightDistribution(0, std::numeric_limits<uint32_t>().max());
+	PoissonGenerator::DefaultPRNG PRNG(generationData.mSeed);
+	const auto points = PoissonGenerator::generatePoissonPoints(generationData.mNrVertices, PRNG, generationData.mIsCircle);
+	const size_t roomCount = std::min(points.size(), static_cast<size_t>(generationData.mNrVertices));
 
-	PoissonGenerator::DefaultPRNG PRNG(mGenerationData.mSeed);
-	auto points = PoissonGenerator::generatePoissonPoints(mGenerationData.mNrVertices, PRNG, mGenerationData.mIsCircle);
+	std::vector<float> coords{};
+	coords.reserve(roomCount * 2);
 
-	if (points.size() > static_cast<size_t>(mGenerationData.mNrVertices))
+	for (size_t i = 0; i < roomCount; i++)
 	{
-		points.erase(points.end() - (points.size() - static_cast<size_t>(mGenerationData.mNrVertices)), points.end());
+		coords.emplace_back(points[i].x * generationData.mSizeX);
+		coords.emplace_back(points[i].y * generationData.mSizeY);
 	}
 
-	std::vector<std::vector<std::vector<uint32_t>>> adjacent(points.size());
-	std::vector<DungeonVertex> vertices;
-	vertices.reserve(points.size());
+#ifdef LOGGING
+	std::cout << "Poisson in "<< TimeToDouble(Timer::now() - start) << " seconds"<< std::endl;
+#endif
+
+	return GenerateInto(generationData, PointSet::Interleaved(coords), sink);
+}
+
+template <GenerationSink Sink>
+GenerationResult GenerateInto(const GenerationData& generationData, const PointSet& pointSet, Sink& sink) {
 
 #ifdef LOGGING
-	std::cout << "Poisson in "<< TimeToDouble(Timer::now() - running) << " seconds"<< std::endl;
-	running = Timer::now();
+	const auto start = Timer::now();
+	auto running = Timer::now();
+	std::cout << "Dungeon generation started" << std::endl;
 #endif
 
-	std::vector<float> coords{};
-	coords.reserve(points.size() * 2);
+	const delaunator::point_view& points = pointSet.mPoints;
+	if (points.size() < 3) {
+		throw std::invalid_argument("A dungeon needs at least 3 rooms");
+	}
+	if (!pointSet.mSizes.empty() && pointSet.mSizes.size() != points.size()) {
+		throw std::length_error("Room sizes do not match the number of points");
+	}
+
+	GenerationResult result{};
 
-	for (auto& point : points)
+	// False when the sink asked to stop
+	const auto& stageCompleted = [&](GenerationStage stage)
+		{
+			if constexpr (requires { { sink.StageCompleted(stage) } -> std::convertible_to<bool>; }) {
+				result.mAborted = !sink.StageCompleted(stage);
+			}
+			else if constexpr (requires { sink.StageCompleted(stage); }) {
+				sink.StageCompleted(stage);
+			}
+			return !result.mAborted;
+		};
+
+	std::mt19937 gen(generationData.mSeed);
+	std::uniform_real_distribution<float> sizeDistribution(generationData.mMinVertexSize, generationData.mMaxVertexSize);
+	std::uniform_int_distribution<std::uint32_t> weightDistribution(0, std::numeric_limits<uint32_t>().max());
+
+	result.mVertexCount = points.size();
+	sink.SetVertexCount(static_cast<uint32_t>(points.size()));
+
+	if (!stageCompleted(GenerationStage::POISSON)) {
+		return result;
+	}
+
+	// Drawn sizes are only kept for the navmesh room flags and size scaled edge weights
+	const bool keepSizes = pointSet.mSizes.empty()
+		&& (generationData.mBuildNavMesh || generationData.mEdgeWeightMode == EdgeWeightMode::SIZE_SCALED);
+	std::vector<float> drawnSizes{};
+	if (keepSizes) {
+		drawnSizes.reserve(points.size());
+	}
+
+	for (uint32_t i = 0; i < points.size(); i++)
 	{
-		const float x = point.x * mGenerationData.mSizeX;
-		const float y = point.y * mGenerationData.mSizeY;
+		const float size = pointSet.mSizes.empty() ? sizeDistribution(gen) : pointSet.mSizes[i];
+		if (keepSizes) {
+			drawnSizes.push_back(size);
+		}
 
-		coords.emplace_back(x);
-		coords.emplace_back(y);
+		sink.SetVertex(i, points.x(i), points.y(i), size);
+	}
+	const std::span<const float> roomSizes = pointSet.mSizes.empty() ? std::span<const float>(drawnSizes) : pointSet.mSizes;
 
-		vertices.emplace_back(x, y, sizeDistribution(gen));
+	if (!stageCompleted(GenerationStage::COORDINATES)) {
+		return result;
 	}
 
 #ifdef LOGGING
-	std::cout << "Converting poisson to coords in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
+	std::cout << "Sizing rooms in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
 	running = Timer::now();
 #endif
 
-	const delaunator::Delaunator delaunay(coords);
+	// The triangulation reads the caller's points in place
+	const delaunator::Delaunator delaunay(points);
+
+	if (!stageCompleted(GenerationStage::TRIANGULATION)) {
+		return result;
+	}
 
 #ifdef LOGGING
 	std::cout << "Delauny in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
 	running = Timer::now();
 #endif
 
-	std::unordered_set<uint64_t> edgeSet{};
+	auto nextHalfEdge = [](size_t e) {
+			return ((e % 3) == 2) ? e - 2 : e + 1;
+		};
 
-	for (std::size_t i = 0; i < delaunay.triangles.size(); i+=3)
+	// Every triangulation edge once, by its lowest half edge
+	std::vector<uint32_t> edgeHalfEdges{};
+	edgeHalfEdges.reserve(delaunay.halfedges.size());
+	for (size_t e = 0; e < delaunay.halfedges.size(); e++)
 	{
-		const auto& addEdge = [&](uint32_t a, uint32_t b)
-			{
-				if (a < b) {
-					std::swap(a, b);
-				}
-				uint64_t edgeKey = ((uint64_t) a << 32) | b;
+		if (delaunay.halfedges[e] == delaunator::INVALID_INDEX || e < delaunay.halfedges[e]) {
+			edgeHalfEdges.push_back(static_cast<uint32_t>(e));
+		}
+	}
+	const size_t edgeCount = edgeHalfEdges.size();
 
-				if (edgeSet.contains(edgeKey))
-				{
-					return;
-				}
+	// Non negative floats order the same as their bit patterns, so every mode ends up as 32 bit sort keys
+	std::vector<uint32_t> weightKeys(edgeCount);
+	if (generationData.mEdgeWeightMode == EdgeWeightMode::RANDOM)
+	{
+		for (auto& key : weightKeys) {
+			key = weightDistribution(gen);
+		}
+	}
+	else
+	{
+		// Gathered into flat arrays first so the weight loop vectorizes
+		std::vector<float> dx(edgeCount), dy(edgeCount), scale(edgeCount, 1.0f);
+		for (size_t i = 0; i < edgeCount; i++)
+		{
+			const size_t a = delaunay.triangles[edgeHalfEdges[i]];
+			const size_t b = delaunay.triangles[nextHalfEdge(edgeHalfEdges[i])];
+			dx[i] = points.x(a) - points.x(b);
+			dy[i] = points.y(a) - points.y(b);
 
-				auto weight = weightDistribution(gen);
-				adjacent[a].push_back({b, weight});
-				adjacent[b].push_back({a, weight});
+			if (generationData.mEdgeWeightMode == EdgeWeightMode::SIZE_SCALED) {
+				scale[i] = 1.0f / (roomSizes[a] + roomSizes[b]);
+			}
+		}
 
-			};
+		if (generationData.mEdgeWeightMode == EdgeWeightMode::JITTERED)
+		{
+			const float jitter = std::max(generationData.mWeightJitter, 0.0f);
+			std::uniform_real_distribution<float> jitterDistribution(0.0f, 1.0f);
+			for (auto& factor : scale) {
+				factor = 1.0f + jitter * jitterDistribution(gen);
+			}
+		}
 
-		addEdge(static_cast<uint32_t>(delaunay.triangles[i]), static_cast<uint32_t>(delaunay.triangles[i + 1]));
-		addEdge(static_cast<uint32_t>(delaunay.triangles[i + 1]), static_cast<uint32_t>(delaunay.triangles[i + 2]));
-		addEdge(static_cast<uint32_t>(delaunay.triangles[i + 2]), static_cast<uint32_t>(delaunay.triangles[i]));
+		for (size_t i = 0; i < edgeCount; i++)
+		{
+			weightKeys[i] = std::bit_cast<uint32_t>(std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]) * scale[i]);
+		}
 	}
 
-	std::vector<DungeonEdge> mstEdges;
-	mstEdges.reserve(edgeSet.size());
+	// Triangulation edges that are part of the dungeon, marked on both half edges
+	std::vector<bool> usedHalfEdges(delaunay.halfedges.size(), false);
+	const auto& markUsed = [&](size_t halfEdge)
+		{
+			usedHalfEdges[halfEdge] = true;
+			if (delaunay.halfedges[halfEdge] != delaunator::INVALID_INDEX) {
+				usedHalfEdges[delaunay.halfedges[halfEdge]] = true;
+			}
+		};
+
+	// Content placement, the path hierarchy and the metrics need the final connectivity, sinks do not have to keep it
+	const bool keepEdges = generationData.mGenerateGameplayContent || generationData.mBuildPathHierarchy || generationData.mComputeMetrics;
+	std::vector<DungeonEdge> finalEdges{};
+	if (keepEdges) {
+		finalEdges.reserve(RequiredBufferSizes(generationData, points.size()).mEdges);
+	}
+	const auto& addEdge = [&](uint32_t a, uint32_t b)
+		{
+			sink.AddEdge(a, b);
+			if (keepEdges) {
+				finalEdges.emplace_back(a, b);
+			}
+			++result.mEdgeCount;
+		};
+
+	if (!stageCompleted(GenerationStage::MST_INIT)) {
+		return result;
+	}
 
 #ifdef LOGGING
 	std::cout << "MST init "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
@@ -214,89 +1036,101 @@ private:
 	uint32_t nrOfSearches = 0;
 #endif
 
-	// 0: weight
-	// 1: connected to
-	// 2: parent
-	std::priority_queue<std::tuple<uint32_t, uint32_t, uint32_t>, std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>, std::greater<>> pq;
-	std::vector<bool> visited(vertices.size(), false);
+	// Kruskal, ties keep the triangulation order so the tree only depends on the seed
+	const auto order = RadixSortIndices(weightKeys);
 
-	pq.emplace(0, 0, std::numeric_limits<uint32_t>().max());
+	std::vector<uint32_t> roots(points.size());
+	std::iota(roots.begin(), roots.end(), 0u);
+	const auto& findRoot = [&](uint32_t room)
+		{
+			while (roots[room] != room) {
+				roots[room] = roots[roots[room]];
+				room = roots[room];
+			}
+			return room;
+		};
 
-	while(!pq.empty())
+	size_t treeEdges = 0;
+	for (uint32_t edge : order)
 	{
-		auto [wt, u, parent] = pq.top();
-		pq.pop();
-
 #ifdef LOGGING
 		++nrOfSearches;
 #endif
 
-		if (visited[u] == true) {
+		const size_t halfEdge = edgeHalfEdges[edge];
+		const auto a = static_cast<uint32_t>(delaunay.triangles[halfEdge]);
+		const auto b = static_cast<uint32_t>(delaunay.triangles[nextHalfEdge(halfEdge)]);
+		const uint32_t rootA = findRoot(a);
+		const uint32_t rootB = findRoot(b);
+		if (rootA == rootB) {
 			continue;
 		}
 
-		visited[u] = true;
+		roots[std::max(rootA, rootB)] = std::min(rootA, rootB);
+		addEdge(a, b);
+		markUsed(halfEdge);
 
-		if (parent != std::numeric_limits<uint32_t>().max()) {
-			mstEdges.emplace_back(parent, u);
-			vertices[u].mConnections.emplace_back(parent);
-			vertices[parent].mConnections.emplace_back(u);
+		if (++treeEdges == points.size() - 1) {
+			break;
 		}
+	}
 
-		for (auto v : adjacent[u]) {
-			if (visited[v[0]] == false) {
-				pq.emplace(v[1], v[0], u);
-			}
-		}
+	if (!stageCompleted(GenerationStage::MST)) {
+		return result;
 	}
 
 #ifdef LOGGING
 	std::cout << "Made MST in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
-	std::cout << "MST required " << nrOfSearches << " searches" << std::endl;
+	std::cout << "MST checked " << nrOfSearches << " edges" << std::endl;
 	running = Timer::now();
 #endif
 
+    // Graph placement runs once the loops are known
+    std::uint32_t startRoom = UNREACHABLE_ROOM, bossRoom = UNREACHABLE_ROOM;
+    if (generationData.mGenerateGameplayContent && generationData.mContentPlacement == ContentPlacement::RANDOM) {
 
-    if (mGenerationData.mGenerateGameplayContent) {
-
-    	std::mt19937 typeGen(mGenerationData.mSeed);
+    	std::mt19937 typeGen(generationData.mSeed);
     	std::uniform_real_distribution<float> roomTypeDistribution(0.0f, 1.0f);
 
-    	for (auto& vert : vertices)
+    	for (uint32_t i = 0; i < points.size(); i++)
     	{
     		float roomType = roomTypeDistribution(typeGen);
-    		vert.mType = roomType < mGenerationData.mTreasureRoomPercentage ? RoomType::TREASURE : RoomType::ENEMY;
+    		sink.SetType(i, roomType < generationData.mTreasureRoomPercentage ? RoomType::TREASURE : RoomType::ENEMY);
     	}
 
-    	vertices.front().mType = RoomType::START;
-    	vertices.back().mType = RoomType::BOSS;
+    	startRoom = 0;
+    	bossRoom = static_cast<uint32_t>(points.size() - 1);
+    	sink.SetType(startRoom, RoomType::START);
+    	sink.SetType(bossRoom, RoomType::BOSS);
 
 #ifdef LOGGING
     	std::cout << "Generated room types in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
     	running = Timer::now();
 #endif
+    }
+    else if (!generationData.mGenerateGameplayContent) {
+    	for (uint32_t i = 0; i < points.size(); i++)
+    	{
+    		sink.SetType(i, RoomType::ENEMY);
+    	}
     }
 
-	auto nextHalfEdge = [](size_t e) {
-			return ((e % 3) == 2) ? e - 2 : e + 1;
-		};
+	if (!stageCompleted(GenerationStage::ROOM_TYPES)) {
+		return result;
+	}
 
 	size_t iterations = 0;
-    int maxIterations = mGenerationData.mNrVertices * 3;
+    int maxIterations = std::max(generationData.mNrVertices, static_cast<int>(points.size())) * 3;
 	std::uniform_int_distribution<size_t> distribution(0, delaunay.halfedges.size() - 1);
-	for (int i = 0; i < mGenerationData.mNrLoops; i++)
+	for (int i = 0; i < generationData.mNrLoops; i++)
 	{
 		++iterations;
 		size_t idx = distribution(gen);
 		auto p1 = delaunay.triangles[idx];
 		auto p2 = delaunay.triangles[nextHalfEdge(idx)];
 
-		auto& p1Connections = vertices[p1].mConnections;
-		auto& p2Connections = vertices[p2].mConnections;
-
 		// If edge already exists continue
-		if (std::find(p1Connections.begin(), p1Connections.end(), p2) != p1Connections.end()
-				|| std::find(p2Connections.begin(), p2Connections.end(), p1) != p2Connections.end())
+		if (usedHalfEdges[idx])
 		{
 			if (iterations > static_cast<size_t>(maxIterations))
 			{
@@ -306,18 +1140,153 @@ private:
 			continue;
 		}
 
-		mstEdges.emplace_back(p1, p2);
-		vertices[p1].mConnections.push_back(p2);
-		vertices[p2].mConnections.push_back(p1);
+		addEdge(static_cast<uint32_t>(p1), static_cast<uint32_t>(p2));
+		markUsed(idx);
+	}
+
+	if (!stageCompleted(GenerationStage::LOOPS)) {
+		return result;
 	}
 
 #ifdef LOGGING
 	std::cout << "Added extra edges in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
+	running = Timer::now();
+#endif
+
+	const auto& setDifficulty = [&](uint32_t index, float difficulty)
+		{
+			if constexpr (requires { sink.SetDifficulty(index, difficulty); }) {
+				sink.SetDifficulty(index, difficulty);
+			}
+		};
+
+	// Threads for the stages that split their work, only for dungeons of at least minRooms rooms
+	const auto& stageThreads = [&](size_t minRooms) -> unsigned
+		{
+			if (points.size() < minRooms) {
+				return 1;
+			}
+			if constexpr (requires { sink.ThreadCount(); }) {
+				return std::max(static_cast<unsigned>(sink.ThreadCount()), 1u);
+			}
+			else {
+				return std::max(std::thread::hardware_concurrency(), 1u);
+			}
+		};
+
+	// Shared by the content placement, the path hierarchy and the metrics
+	const RoomGraph graph = keepEdges ? RoomGraph(points.size(), finalEdges) : RoomGraph{};
+
+	if (generationData.mGenerateGameplayContent) {
+		std::vector<float> difficulty(points.size(), 0.0f);
+
+		if (generationData.mContentPlacement == ContentPlacement::GRAPH) {
+			const unsigned threadCount = stageThreads(PARALLEL_CONTENT_ROOMS);
+			std::vector<RoomType> types(points.size(), RoomType::ENEMY);
+			const auto rules = DefaultContentRules();
+			const RoomMetrics metrics = PlaceContent(graph, generationData, types, difficulty, rules, threadCount);
+			startRoom = metrics.mStart;
+			bossRoom = metrics.mBoss;
+
+			for (uint32_t i = 0; i < points.size(); i++) {
+				sink.SetType(i, types[i]);
+			}
+		}
+		else {
+			// START is room 0 here
+			const RoomMetrics metrics = ComputeRoomMetrics(graph, 0);
+			const ContentContext context{ graph, metrics, generationData, {}, difficulty };
+			for (uint32_t i = 0; i < points.size(); i++) {
+				DifficultyRule(context, i);
+			}
+		}
+
+		for (uint32_t i = 0; i < points.size(); i++) {
+			setDifficulty(i, difficulty[i]);
+		}
+	}
+	else {
+		for (uint32_t i = 0; i < points.size(); i++) {
+			setDifficulty(i, 0.0f);
+		}
+	}
+
+	if (!stageCompleted(GenerationStage::CONTENT)) {
+		return result;
+	}
+
+#ifdef LOGGING
+	std::cout << "Placed content in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
+	running = Timer::now();
+#endif
+
+	// The navmesh and the path hierarchy keep their own interleaved copy of the positions
+	std::vector<float> coords{};
+	const auto& interleaved = [&]() -> std::span<const float>
+		{
+			if (points.stride == 2 && points.ys == points.xs + 1) {
+				return { points.xs, points.size() * 2 };
+			}
+			if (coords.empty()) {
+				coords.reserve(points.size() * 2);
+				for (size_t i = 0; i < points.size(); i++) {
+					coords.push_back(points.x(i));
+					coords.push_back(points.y(i));
+				}
+			}
+			return coords;
+		};
+
+	if (generationData.mBuildNavMesh) {
+		NavMesh navMesh(interleaved(), delaunay.triangles, delaunay.halfedges, usedHalfEdges, roomSizes);
+		if constexpr (requires { sink.SetNavMesh(std::move(navMesh)); }) {
+			sink.SetNavMesh(std::move(navMesh));
+		}
+	}
+
+	if (!stageCompleted(GenerationStage::NAVMESH)) {
+		return result;
+	}
+
+#ifdef LOGGING
+	std::cout << "Built navmesh in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
+	running = Timer::now();
+#endif
+
+	if (generationData.mBuildPathHierarchy) {
+		const unsigned threadCount = stageThreads(PARALLEL_HIERARCHY_ROOMS);
+		PathHierarchy pathHierarchy(interleaved(), graph, generationData.mClusterSize, threadCount);
+		if constexpr (requires { sink.SetPathHierarchy(std::move(pathHierarchy)); }) {
+			sink.SetPathHierarchy(std::move(pathHierarchy));
+		}
+	}
+
+	if (!stageCompleted(GenerationStage::HIERARCHY)) {
+		return result;
+	}
+
+#ifdef LOGGING
+	std::cout << "Built path hierarchy in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
+	running = Timer::now();
+#endif
+
+	if (generationData.mComputeMetrics) {
+		DungeonMetrics metrics = ComputeDungeonMetrics(graph, finalEdges, interleaved(), startRoom, bossRoom);
+		if constexpr (requires { sink.SetMetrics(std::move(metrics)); }) {
+			sink.SetMetrics(std::move(metrics));
+		}
+	}
+
+	if (!stageCompleted(GenerationStage::METRICS)) {
+		return result;
+	}
+
+#ifdef LOGGING
+	std::cout << "Computed metrics in "<< TimeToDouble(Timer::now() - running) << " seconds" << std::endl;
 	std::cout << "Dungeon generated in "<< TimeToDouble(Timer::now() - start) << " seconds" << std::endl;
 #endif
 
-	mVertices = vertices;
-	mEdges = mstEdges;
+	return result;
 }
 
 }
\ No newline at end of file
@@ -44,13 +44,14 @@
  *		1.0     May  6, 2014
 */
 
+#include <cstring>
 #include <vector>
 #include <stdint.h>
 
 namespace PoissonGenerator
 {
 
-const char* Version = "1.4.1 (12/12/2021)";
+inline const char* Version = "1.4.1 (12/12/2021)";
 
 class DefaultPRNG
 {
@@ -61,8 +62,10 @@ public:
 	{
 		seed_ *= 521167;
 		uint32_t a = (seed_ & 0x007fffff) | 0x40000000;
+		float f;
+		std::memcpy(&f, &a, sizeof(f));
 		// remap to 0..1
-		return 0.5f * (*((float*)&a) - 2.0f);
+		return 0.5f * (f - 2.0f);
 	}
 	inline uint32_t randomInt(uint32_t maxInt)
 	{
@@ -121,12 +124,12 @@ struct GridPoint
 	int y;
 };
 
-float getDistance( const Point& P1, const Point& P2 )
+inline float getDistance( const Point& P1, const Point& P2 )
 {
 	return sqrt( ( P1.x - P2.x ) * ( P1.x - P2.x ) + ( P1.y - P2.y ) * ( P1.y - P2.y ) );
 }
 
-GridPoint imageToGrid( const Point& P, float cellSize )
+inline GridPoint imageToGrid( const Point& P, float cellSize )
 {
 	return GridPoint( ( int )( P.x / cellSize ), ( int )( P.y / cellSize ) );
 }
@@ -305,7 +308,7 @@ std::vector<Point> generatePoissonPoints(
 	return samplePoints;
 }
 
-Point sampleVogelDisk(uint32_t idx, uint32_t numPoints, float phi)
+inline Point sampleVogelDisk(uint32_t idx, uint32_t numPoints, float phi)
 {
 	const float kGoldenAngle = 2.4f;
 
@@ -318,7 +321,7 @@ Point sampleVogelDisk(uint32_t idx, uint32_t numPoints, float phi)
 /**
 	Return a vector of generated points
 **/
-std::vector<Point> generateVogelPoints(uint32_t numPoints, bool isCircle = true, float phi = 0.0f, Point center = Point(0.5f, 0.5f))
+inline std::vector<Point> generateVogelPoints(uint32_t numPoints, bool isCircle = true, float phi = 0.0f, Point center = Point(0.5f, 0.5f))
 {
 	std::vector<Point> samplePoints;
 
@@ -377,7 +380,7 @@ std::vector<Point> generateJitteredGridPoints(
 namespace {
 
 // http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
-float radicalInverse_VdC(uint32_t bits)
+inline float radicalInverse_VdC(uint32_t bits)
 {
 	bits = (bits << 16u) | (bits >> 16u);
 	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
@@ -387,7 +390,7 @@ float radicalInverse_VdC(uint32_t bits)
 	return float(float(bits) * 2.3283064365386963e-10); // / 0x100000000
 }
 
-Point hammersley2d(uint32_t i, uint32_t N)
+inline Point hammersley2d(uint32_t i, uint32_t N)
 {
 	return Point(float(i)/float(N), radicalInverse_VdC(i));
 }
@@ -397,7 +400,7 @@ Point hammersley2d(uint32_t i, uint32_t N)
 /**
 	Return a vector of generated points
 **/
-std::vector<Point> generateHammersleyPoints(
+inline std::vector<Point> generateHammersleyPoints(
 	uint32_t numPoints
 )
 {
@@ -93,17 +93,35 @@ inline std::pair<float, float> circumcenter(
     return std::make_pair(x, y);
 }
 
+// Read only view of 2D points, either interleaved x, y (stride 2) or separate x and y arrays (stride 1)
+struct point_view {
+    const float* xs = nullptr;
+    const float* ys = nullptr;
+    std::size_t stride = 2;
+    std::size_t count = 0;
+
+    point_view() = default;
+    point_view(std::vector<float> const& interleaved)
+        : xs(interleaved.data()), ys(interleaved.empty() ? nullptr : interleaved.data() + 1), stride(2), count(interleaved.size() >> 1) {}
+    point_view(const float* in_xs, const float* in_ys, std::size_t in_stride, std::size_t in_count)
+        : xs(in_xs), ys(in_ys), stride(in_stride), count(in_count) {}
+
+    float x(std::size_t i) const { return xs[i * stride]; }
+    float y(std::size_t i) const { return ys[i * stride]; }
+    std::size_t size() const { return count; }
+};
+
 inline float compare(
-    std::vector<float> const& coords,
+    point_view const& points,
     std::size_t i,
     std::size_t j,
     float cx,
     float cy) {
-    const float d1 = dist(coords[2 * i], coords[2 * i + 1], cx, cy);
-    const float d2 = dist(coords[2 * j], coords[2 * j + 1], cx, cy);
+    const float d1 = dist(points.x(i), points.y(i), cx, cy);
+    const float d2 = dist(points.x(j), points.y(j), cx, cy);
     const float diff1 = d1 - d2;
-    const float diff2 = coords[2 * i] - coords[2 * j];
-    const float diff3 = coords[2 * i + 1] - coords[2 * j + 1];
+    const float diff2 = points.x(i) - points.x(j);
+    const float diff3 = points.y(i) - points.y(j);
 
     if (diff1 > 0.0f || diff1 < 0.0f) {
         return diff1;
@@ -116,12 +134,12 @@ inline float compare(
 
 struct sort_to_center {
 
-    std::vector<float> const& coords;
+    point_view points;
     float cx;
     float cy;
 
     bool operator()(std::size_t i, std::size_t j) {
-        return compare(coords, i, j, cx, cy) < 0;
+        return compare(points, i, j, cx, cy) < 0;
     }
 };
 
@@ -177,7 +195,7 @@ struct DelaunatorPoint {
 class Delaunator {
 
 public:
-    std::vector<float> const& coords;
+    point_view points; // Not owned, must outlive the triangulation
     std::vector<std::size_t> triangles;
     std::vector<std::size_t> halfedges;
     std::vector<std::size_t> hull_prev;
@@ -185,7 +203,7 @@ public:
     std::vector<std::size_t> hull_tri;
     std::size_t hull_start;
 
-    Delaunator(std::vector<float> const& in_coords);
+    Delaunator(point_view in_points);
 
     float get_hull_area();
 
@@ -207,8 +225,8 @@ private:
     void link(std::size_t a, std::size_t b);
 };
 
-Delaunator::Delaunator(std::vector<float> const& in_coords)
-    : coords(in_coords),
+inline Delaunator::Delaunator(point_view in_points)
+    : points(in_points),
       triangles(),
       halfedges(),
       hull_prev(),
@@ -219,7 +237,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
       m_center_x(),
       m_center_y(),
       m_hash_size() {
-    std::size_t n = coords.size() >> 1;
+    std::size_t n = points.size();
 
     float max_x = std::numeric_limits<float>::min();
     float max_y = std::numeric_limits<float>::min();
@@ -229,8 +247,8 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
     ids.reserve(n);
 
     for (std::size_t i = 0; i < n; i++) {
-        const float x = coords[2 * i];
-        const float y = coords[2 * i + 1];
+        const float x = points.x(i);
+        const float y = points.y(i);
 
         if (x < min_x) min_x = x;
         if (y < min_y) min_y = y;
@@ -249,30 +267,30 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
 
     // pick a seed point close to the centroid
     for (std::size_t i = 0; i < n; i++) {
-        const float d = dist(cx, cy, coords[2 * i], coords[2 * i + 1]);
+        const float d = dist(cx, cy, points.x(i), points.y(i));
         if (d < min_dist) {
             i0 = i;
             min_dist = d;
         }
     }
 
-    const float i0x = coords[2 * i0];
-    const float i0y = coords[2 * i0 + 1];
+    const float i0x = points.x(i0);
+    const float i0y = points.y(i0);
 
     min_dist = std::numeric_limits<float>::max();
 
     // find the point closest to the seed
     for (std::size_t i = 0; i < n; i++) {
         if (i == i0) continue;
-        const float d = dist(i0x, i0y, coords[2 * i], coords[2 * i + 1]);
+        const float d = dist(i0x, i0y, points.x(i), points.y(i));
         if (d < min_dist && d > 0.0f) {
             i1 = i;
             min_dist = d;
         }
     }
 
-    float i1x = coords[2 * i1];
-    float i1y = coords[2 * i1 + 1];
+    float i1x = points.x(i1);
+    float i1y = points.y(i1);
 
     float min_radius = std::numeric_limits<float>::max();
 
@@ -281,7 +299,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         if (i == i0 || i == i1) continue;
 
         const float r = circumradius(
-            i0x, i0y, i1x, i1y, coords[2 * i], coords[2 * i + 1]);
+            i0x, i0y, i1x, i1y, points.x(i), points.y(i));
 
         if (r < min_radius) {
             i2 = i;
@@ -293,8 +311,8 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         throw std::runtime_error("not triangulation");
     }
 
-    float i2x = coords[2 * i2];
-    float i2y = coords[2 * i2 + 1];
+    float i2x = points.x(i2);
+    float i2y = points.y(i2);
 
     if (orient(i0x, i0y, i1x, i1y, i2x, i2y)) {
         std::swap(i1, i2);
@@ -305,7 +323,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
     std::tie(m_center_x, m_center_y) = circumcenter(i0x, i0y, i1x, i1y, i2x, i2y);
 
     // sort the points by distance from the seed triangle circumcenter
-    std::sort(ids.begin(), ids.end(), sort_to_center{ coords, m_center_x, m_center_y });
+    std::sort(ids.begin(), ids.end(), sort_to_center{ points, m_center_x, m_center_y });
 
     // initialize a hash table for storing edges of the advancing convex hull
     m_hash_size = static_cast<std::size_t>(std::llround(std::ceil(std::sqrt(n))));
@@ -341,8 +359,8 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
     float yp = std::numeric_limits<float>::quiet_NaN();
     for (std::size_t k = 0; k < n; k++) {
         const std::size_t i = ids[k];
-        const float x = coords[2 * i];
-        const float y = coords[2 * i + 1];
+        const float x = points.x(i);
+        const float y = points.y(i);
 
         // skip near-duplicate points
         if (k > 0 && check_pts_equal(x, y, xp, yp)) continue;
@@ -368,7 +386,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         size_t e = start;
         size_t q;
 
-        while (q = hull_next[e], !orient(x, y, coords[2 * e], coords[2 * e + 1], coords[2 * q], coords[2 * q + 1])) { //TODO: does it works in a same way as in JS
+        while (q = hull_next[e], !orient(x, y, points.x(e), points.y(e), points.x(q), points.y(q))) { //TODO: does it works in a same way as in JS
             e = q;
             if (e == start) {
                 e = INVALID_INDEX;
@@ -395,7 +413,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         std::size_t next = hull_next[e];
         while (
             q = hull_next[next],
-            orient(x, y, coords[2 * next], coords[2 * next + 1], coords[2 * q], coords[2 * q + 1])) {
+            orient(x, y, points.x(next), points.y(next), points.x(q), points.y(q))) {
             t = add_triangle(next, i, q, hull_tri[i], INVALID_INDEX, hull_tri[next]);
             hull_tri[i] = legalize(t + 2);
             hull_next[next] = next; // mark as removed
@@ -407,7 +425,7 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         if (e == start) {
             while (
                 q = hull_prev[e],
-                orient(x, y, coords[2 * q], coords[2 * q + 1], coords[2 * e], coords[2 * e + 1])) {
+                orient(x, y, points.x(q), points.y(q), points.x(e), points.y(e))) {
                 t = add_triangle(q, i, e, INVALID_INDEX, hull_tri[e], hull_tri[q]);
                 legalize(t + 2);
                 hull_tri[q] = t;
@@ -425,21 +443,21 @@ Delaunator::Delaunator(std::vector<float> const& in_coords)
         hull_next[i] = next;
 
         m_hash[hash_key(x, y)] = i;
-        m_hash[hash_key(coords[2 * e], coords[2 * e + 1])] = e;
+        m_hash[hash_key(points.x(e), points.y(e))] = e;
     }
 }
 
-float Delaunator::get_hull_area() {
+inline float Delaunator::get_hull_area() {
     std::vector<float> hull_area;
     size_t e = hull_start;
     do {
-        hull_area.push_back((coords[2 * e] - coords[2 * hull_prev[e]]) * (coords[2 * e + 1] + coords[2 * hull_prev[e] + 1]));
+        hull_area.push_back((points.x(e) - points.x(hull_prev[e])) * (points.y(e) + points.y(hull_prev[e])));
         e = hull_next[e];
     } while (e != hull_start);
     return sum(hull_area);
 }
 
-std::size_t Delaunator::legalize(std::size_t a) {
+inline std::size_t Delaunator::legalize(std::size_t a) {
     const std::size_t b = halfedges[a];
 
     /* if the pair of triangles doesn't satisfy the Delaunay condition
@@ -474,14 +492,14 @@ std::size_t Delaunator::legalize(std::size_t a) {
     }
 
     const bool illegal = in_circle(
-        coords[2 * p0],
-        coords[2 * p0 + 1],
-        coords[2 * pr],
-        coords[2 * pr + 1],
-        coords[2 * pl],
-        coords[2 * pl + 1],
-        coords[2 * p1],
-        coords[2 * p1 + 1]);
+        points.x(p0),
+        points.y(p0),
+        points.x(pr),
+        points.y(pr),
+        points.x(pl),
+        points.y(pl),
+        points.x(p1),
+        points.y(p1));
 
     if (illegal) {
         triangles[a] = p1;
@@ -512,7 +530,7 @@ std::size_t Delaunator::legalize(std::size_t a) {
     return ar;
 }
 
-std::size_t Delaunator::hash_key(float x, float y) {
+inline std::size_t Delaunator::hash_key(float x, float y) {
     const float dx = x - m_center_x;
     const float dy = y - m_center_y;
     return static_cast<std::size_t>(std::llround(
@@ -520,7 +538,7 @@ std::size_t Delaunator::hash_key(float x, float y) {
            m_hash_size;
 }
 
-std::size_t Delaunator::add_triangle(
+inline std::size_t Delaunator::add_triangle(
     std::size_t i0,
     std::size_t i1,
     std::size_t i2,
@@ -537,7 +555,7 @@ std::size_t Delaunator::add_triangle(
     return t;
 }
 
-void Delaunator::link(std::size_t a, std::size_t b) {
+inline void Delaunator::link(std::size_t a, std::size_t b) {
     std::size_t s = halfedges.size();
     if (a == s) {
         halfedges.push_back(b);
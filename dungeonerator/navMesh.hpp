@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace DungeonGenerator
+{
+
+// The Delaunay triangulation of the room centres, kept by the generator when GenerationData::mBuildNavMesh is set.
+// Triangle t has the corners mTriangles[3t..3t+2], half edge e runs from corner e to the next corner of its triangle
+// and mHalfEdges[e] is the opposite half edge in the neighbouring triangle, or INVALID on the hull.
+class NavMesh
+{
+public:
+    static constexpr std::uint32_t INVALID = std::numeric_limits<std::uint32_t>::max();
+
+    enum Flags : std::uint8_t
+    {
+        WALL = 0, // Not walkable
+        CORRIDOR = 1 << 0, // One of the edges is a corridor
+        ROOM = 1 << 1, // The centre lies inside one of the corner rooms
+    };
+
+    struct Point
+    {
+        float mX{};
+        float mY{};
+
+        bool operator==(const Point&) const = default;
+    };
+
+    NavMesh() = default;
+
+    // corridorHalfEdges marks both half edges of every edge that became a corridor, roomSizes is the radius per room
+    NavMesh(std::span<const float> coords, std::span<const std::size_t> triangles, std::span<const std::size_t> halfEdges,
+        const std::vector<bool>& corridorHalfEdges, std::span<const float> roomSizes)
+        : mCoords(coords.begin(), coords.end())
+    {
+        mTriangles.reserve(triangles.size());
+        mHalfEdges.reserve(halfEdges.size());
+        for (std::size_t corner : triangles) {
+            mTriangles.push_back(static_cast<std::uint32_t>(corner));
+        }
+        for (std::size_t twin : halfEdges) {
+            mHalfEdges.push_back(twin >= halfEdges.size() ? INVALID : static_cast<std::uint32_t>(twin));
+        }
+
+        mFlags.assign(TriangleCount(), WALL);
+        for (std::uint32_t t = 0; t < TriangleCount(); t++) {
+            const Point centre = Centroid(t);
+            for (std::uint32_t e = 3 * t; e < 3 * t + 3; e++) {
+                if (corridorHalfEdges[e]) {
+                    mFlags[t] |= CORRIDOR;
+                }
+
+                const Point corner = Vertex(mTriangles[e]);
+                const float radius = roomSizes[mTriangles[e]];
+                if (Distance(corner, centre) < radius) {
+                    mFlags[t] |= ROOM;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] std::uint32_t TriangleCount() const { return static_cast<std::uint32_t>(mTriangles.size() / 3); }
+    [[nodiscard]] bool Empty() const { return mTriangles.empty(); }
+
+    [[nodiscard]] Point Vertex(std::uint32_t vertex) const { return { mCoords[2 * vertex], mCoords[2 * vertex + 1] }; }
+    [[nodiscard]] std::uint32_t Corner(std::uint32_t triangle, std::uint32_t i) const { return mTriangles[3 * triangle + i]; }
+    [[nodiscard]] std::uint32_t Twin(std::uint32_t halfEdge) const { return mHalfEdges[halfEdge]; }
+    [[nodiscard]] std::uint8_t GetFlags(std::uint32_t triangle) const { return mFlags[triangle]; }
+    [[nodiscard]] bool Walkable(std::uint32_t triangle) const { return mFlags[triangle] != WALL; }
+
+    [[nodiscard]] static std::uint32_t NextHalfEdge(std::uint32_t e) { return e % 3 == 2 ? e - 2 : e + 1; }
+
+    [[nodiscard]] Point Centroid(std::uint32_t triangle) const
+    {
+        const Point a = Vertex(Corner(triangle, 0)), b = Vertex(Corner(triangle, 1)), c = Vertex(Corner(triangle, 2));
+        return { (a.mX + b.mX + c.mX) / 3.0f, (a.mY + b.mY + c.mY) / 3.0f };
+    }
+
+    // Walks from the hint triangle towards the point, crossing the edge the point lies behind.
+    // Returns the triangle that contains the point, or INVALID when it lies outside the mesh.
+    [[nodiscard]] std::uint32_t Locate(Point point, std::uint32_t hint = 0) const
+    {
+        if (Empty()) {
+            return INVALID;
+        }
+
+        std::uint32_t triangle = hint < TriangleCount() ? hint : 0;
+        // A walk on a Delaunay triangulation cannot cycle, the limit only guards against rounding
+        for (std::uint32_t step = 0; step <= TriangleCount(); step++) {
+            const std::uint32_t exit = ExitEdge(triangle, point);
+            if (exit == INVALID) {
+                return triangle;
+            }
+            if (mHalfEdges[exit] == INVALID) {
+                return INVALID;
+            }
+            triangle = mHalfEdges[exit] / 3;
+        }
+
+        for (std::uint32_t t = 0; t < TriangleCount(); t++) {
+            if (ExitEdge(t, point) == INVALID) {
+                return t;
+            }
+        }
+        return INVALID;
+    }
+
+    // A* over walkable triangles, the start and goal triangles are always allowed.
+    // Returns the triangles from start to goal, empty when the goal cannot be reached.
+    [[nodiscard]] std::vector<std::uint32_t> FindTrianglePath(std::uint32_t start, std::uint32_t goal) const
+    {
+        if (start >= TriangleCount() || goal >= TriangleCount()) {
+            return {};
+        }
+
+        const Point target = Centroid(goal);
+        std::vector<float> cost(TriangleCount(), std::numeric_limits<float>::infinity());
+        std::vector<std::uint32_t> parent(TriangleCount(), INVALID);
+
+        using QueueEntry = std::pair<float, std::uint32_t>;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> open;
+        cost[start] = 0.0f;
+        open.emplace(Distance(Centroid(start), target), start);
+
+        while (!open.empty()) {
+            const auto [estimate, triangle] = open.top();
+            open.pop();
+
+            if (triangle == goal) {
+                break;
+            }
+            // Outdated entry, the triangle was reached more cheaply since
+            if (estimate > cost[triangle] + Distance(Centroid(triangle), target) + 1e-3f) {
+                continue;
+            }
+
+            for (std::uint32_t e = 3 * triangle; e < 3 * triangle + 3; e++) {
+                const std::uint32_t twin = mHalfEdges[e];
+                if (twin == INVALID) {
+                    continue;
+                }
+                const std::uint32_t next = twin / 3;
+                if (!Walkable(next) && next != goal) {
+                    continue;
+                }
+
+                const float nextCost = cost[triangle] + Distance(Centroid(triangle), Centroid(next));
+                if (nextCost < cost[next]) {
+                    cost[next] = nextCost;
+                    parent[next] = triangle;
+                    open.emplace(nextCost + Distance(Centroid(next), target), next);
+                }
+            }
+        }
+
+        if (start != goal && parent[goal] == INVALID) {
+            return {};
+        }
+
+        std::vector<std::uint32_t> path;
+        for (std::uint32_t t = goal; t != INVALID; t = parent[t]) {
+            path.push_back(t);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // Shortest path through the corridor of triangles with the funnel algorithm, starting at from and ending at to.
+    // Empty when the corridor is not a chain of adjacent triangles of this mesh.
+    [[nodiscard]] std::vector<Point> Funnel(std::span<const std::uint32_t> triangles, Point from, Point to) const
+    {
+        if (triangles.empty() || triangles.front() >= TriangleCount()) {
+            return {};
+        }
+
+        // Portals as (left, right) when walking along the path
+        std::vector<std::pair<Point, Point>> portals;
+        portals.reserve(triangles.size() + 1);
+        portals.emplace_back(from, from);
+        for (std::size_t i = 0; i + 1 < triangles.size(); i++) {
+            const std::uint32_t edge = SharedEdge(triangles[i], triangles[i + 1]);
+            if (edge == INVALID) {
+                return {};
+            }
+            Point a = Vertex(mTriangles[edge]);
+            Point b = Vertex(mTriangles[NextHalfEdge(edge)]);
+            // A start on the edge would open the funnel to a half plane, the walk simply begins behind it
+            if (portals.size() == 1 && Cross(a, b, from) == 0.0f) {
+                continue;
+            }
+            if (Cross(Centroid(triangles[i]), a, b) < 0.0f) {
+                std::swap(a, b);
+            }
+            portals.emplace_back(b, a);
+        }
+        portals.emplace_back(to, to);
+
+        std::vector<Point> path{ from };
+        Point apex = from, left = from, right = from;
+        std::size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+
+        for (std::size_t i = 1; i < portals.size(); i++) {
+            const auto& [portalLeft, portalRight] = portals[i];
+
+            // Tighten the right side, or restart from the left corner when it crosses over
+            if (Cross(apex, right, portalRight) >= 0.0f) {
+                if (apex == right || Cross(apex, left, portalRight) < 0.0f) {
+                    right = portalRight;
+                    rightIndex = i;
+                } else {
+                    apex = right = left;
+                    apexIndex = rightIndex = leftIndex;
+                    // Consecutive portals can share the corner, it is only added once
+                    if (!(path.back() == apex)) {
+                        path.push_back(apex);
+                    }
+                    i = apexIndex;
+                    continue;
+                }
+            }
+
+            // Tighten the left side, or restart from the right corner when it crosses over
+            if (Cross(apex, left, portalLeft) <= 0.0f) {
+                if (apex == left || Cross(apex, right, portalLeft) > 0.0f) {
+                    left = portalLeft;
+                    leftIndex = i;
+                } else {
+                    apex = left = right;
+                    apexIndex = leftIndex = rightIndex;
+                    // Consecutive portals can share the corner, it is only added once
+                    if (!(path.back() == apex)) {
+                        path.push_back(apex);
+                    }
+                    i = apexIndex;
+                    continue;
+                }
+            }
+        }
+
+        if (!(path.back() == to)) {
+            path.push_back(to);
+        }
+        return path;
+    }
+
+    // Point path between two positions, empty when either lies outside the mesh or no walkable route exists
+    [[nodiscard]] std::vector<Point> FindPath(Point from, Point to) const
+    {
+        const std::uint32_t start = Locate(from);
+        const std::uint32_t goal = Locate(to, start);
+        if (start == INVALID || goal == INVALID) {
+            return {};
+        }
+
+        // A* between centroids can pick a corridor around the straight line, which the funnel cannot straighten
+        auto triangles = StraightCorridor(start, goal, from, to);
+        if (triangles.empty()) {
+            triangles = FindTrianglePath(start, goal);
+        }
+        if (triangles.empty()) {
+            return {};
+        }
+        return Funnel(triangles, from, to);
+    }
+
+    // Triangles crossed by the segment from start to goal, empty when it leaves the mesh or crosses a triangle
+    // that is not walkable. The start and goal triangles are always allowed, like in FindTrianglePath.
+    [[nodiscard]] std::vector<std::uint32_t> StraightCorridor(std::uint32_t start, std::uint32_t goal, Point from, Point to) const
+    {
+        if (start >= TriangleCount() || goal >= TriangleCount()) {
+            return {};
+        }
+
+        std::vector<std::uint32_t> triangles{ start };
+        std::uint32_t entry = INVALID;
+        for (std::uint32_t triangle = start; triangle != goal;) {
+            if (triangles.size() > TriangleCount()) {
+                return {};
+            }
+
+            // The edge with the goal on its far side that the segment passes through
+            std::uint32_t exit = INVALID;
+            for (std::uint32_t e = 3 * triangle; e < 3 * triangle + 3 && exit == INVALID; e++) {
+                const Point a = Vertex(mTriangles[e]);
+                const Point b = Vertex(mTriangles[NextHalfEdge(e)]);
+                const Point c = Vertex(mTriangles[NextHalfEdge(NextHalfEdge(e))]);
+                const float inside = Cross(a, b, c);
+                const float side = Cross(a, b, to);
+                const bool behind = (inside > 0.0f && side <= 0.0f) || (inside < 0.0f && side >= 0.0f);
+                const float sideA = Cross(from, to, a), sideB = Cross(from, to, b);
+                if (e != entry && behind && ((sideA <= 0.0f && sideB >= 0.0f) || (sideA >= 0.0f && sideB <= 0.0f))) {
+                    exit = e;
+                }
+            }
+            if (exit == INVALID || mHalfEdges[exit] == INVALID) {
+                return {};
+            }
+
+            entry = mHalfEdges[exit];
+            triangle = entry / 3;
+            if (!Walkable(triangle) && triangle != goal) {
+                return {};
+            }
+            triangles.push_back(triangle);
+        }
+        return triangles;
+    }
+
+    [[nodiscard]] std::size_t MemoryUsage() const
+    {
+        return mCoords.capacity() * sizeof(float) + mTriangles.capacity() * sizeof(std::uint32_t)
+            + mHalfEdges.capacity() * sizeof(std::uint32_t) + mFlags.capacity() * sizeof(std::uint8_t);
+    }
+
+    // Raw arrays, for serialization
+    std::vector<float> mCoords{}; // Interleaved x, y per room
+    std::vector<std::uint32_t> mTriangles{};
+    std::vector<std::uint32_t> mHalfEdges{};
+    std::vector<std::uint8_t> mFlags{}; // Flags per triangle
+
+private:
+    [[nodiscard]] static float Distance(Point a, Point b) { return std::hypot(a.mX - b.mX, a.mY - b.mY); }
+
+    // Positive when c lies counter clockwise of the direction from a to b
+    [[nodiscard]] static float Cross(Point a, Point b, Point c)
+    {
+        return (b.mX - a.mX) * (c.mY - a.mY) - (b.mY - a.mY) * (c.mX - a.mX);
+    }
+
+    // Half edge of the triangle with the point strictly on its far side, INVALID when the triangle contains the point
+    [[nodiscard]] std::uint32_t ExitEdge(std::uint32_t triangle, Point point) const
+    {
+        for (std::uint32_t e = 3 * triangle; e < 3 * triangle + 3; e++) {
+            const Point a = Vertex(mTriangles[e]);
+            const Point b = Vertex(mTriangles[NextHalfEdge(e)]);
+            const Point c = Vertex(mTriangles[NextHalfEdge(NextHalfEdge(e))]);
+            const float inside = Cross(a, b, c);
+            const float side = Cross(a, b, point);
+            if ((inside > 0.0f && side < 0.0f) || (inside < 0.0f && side > 0.0f)) {
+                return e;
+            }
+        }
+        return INVALID;
+    }
+
+    [[nodiscard]] std::uint32_t SharedEdge(std::uint32_t from, std::uint32_t to) const
+    {
+        for (std::uint32_t e = 3 * from; e < 3 * from + 3; e++) {
+            if (mHalfEdges[e] != INVALID && mHalfEdges[e] / 3 == to) {
+                return e;
+            }
+        }
+        return INVALID;
+    }
+};
+
+}
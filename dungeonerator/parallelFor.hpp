@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace DungeonGenerator
+{
+
+// Runs worker() on threadCount threads, the calling thread being one of them, and waits for all
+template <typename Worker>
+void RunOnThreads(unsigned threadCount, const Worker& worker)
+{
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; i++) {
+        threads.emplace_back([&, i]() { worker(i); });
+    }
+    worker(0u);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Calls fn(begin, end) on contiguous chunks of [0, count), the calling thread takes the first chunk
+template <typename Fn>
+void ParallelFor(std::size_t count, unsigned threadCount, const Fn& fn)
+{
+    threadCount = static_cast<unsigned>(std::clamp<std::size_t>(threadCount, 1, std::max<std::size_t>(count, 1)));
+    const std::size_t chunk = (count + threadCount - 1) / threadCount;
+
+    RunOnThreads(threadCount, [&](unsigned i) { fn(std::min(count, i * chunk), std::min(count, (i + 1) * chunk)); });
+}
+
+// Calls fn(index) for every index in [0, count), each thread taking the next index once it is done with its last,
+// so work of uneven size keeps every thread busy. Indices are handed out in ascending order. When fn returns a bool,
+// false stops handing out indices, calls that already started still finish.
+template <typename Fn>
+void ParallelForEach(std::size_t count, unsigned threadCount, const Fn& fn)
+{
+    threadCount = static_cast<unsigned>(std::clamp<std::size_t>(threadCount, 1, std::max<std::size_t>(count, 1)));
+    std::atomic<std::size_t> next = 0;
+
+    RunOnThreads(threadCount, [&](unsigned)
+        {
+            for (std::size_t i = next++; i < count; i = next++) {
+                if constexpr (std::is_same_v<std::invoke_result_t<const Fn&, std::size_t>, bool>) {
+                    if (!fn(i)) {
+                        next = count;
+                        return;
+                    }
+                }
+                else {
+                    fn(i);
+                }
+            }
+        });
+}
+
+}
@@ -0,0 +1,718 @@
+#pragma once
+
+#include "parallelFor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace DungeonGenerator
+{
+
+// Rooms grouped into square clusters, with a shortest path tree inside its cluster precomputed for every portal room.
+// Portal rooms have a corridor into another cluster. Long paths are searched over the portals only and then
+// refined by walking the trees of the portals they pass (HPA*). Costs are the distances between the room centres.
+// Corridors mostly form a tree, so the search is guided by distances to a few landmark rooms (ALT) on top of the
+// straight line distance, which alone barely prunes anything.
+class PathHierarchy
+{
+public:
+    static constexpr std::uint32_t INVALID = std::numeric_limits<std::uint32_t>::max();
+    static constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+    static constexpr float DEFAULT_CLUSTER_ROOMS = 64.0f; // Average rooms per cluster when no cluster size is given
+    static constexpr std::uint32_t LANDMARK_COUNT = 8;
+
+    struct Path
+    {
+        std::vector<std::uint32_t> mRooms{}; // From start to goal, empty when the goal cannot be reached
+        float mLength = UNREACHABLE;
+    };
+
+    PathHierarchy() = default;
+
+    // positions are interleaved x, y per room, graph provides RoomCount() and Neighbours(room).
+    // A cluster size of 0 or less picks one that gives about DEFAULT_CLUSTER_ROOMS rooms per cluster.
+    // The result does not depend on the number of threads.
+    template <typename Graph>
+    PathHierarchy(std::span<const float> positions, const Graph& graph, float clusterSize = 0.0f, unsigned threadCount = 1)
+        : mPositions(positions.begin(), positions.end())
+    {
+        const std::uint32_t roomCount = graph.RoomCount();
+        mOffsets.reserve(roomCount + 1);
+        mOffsets.push_back(0);
+        for (std::uint32_t room = 0; room < roomCount; room++) {
+            const auto neighbours = graph.Neighbours(room);
+            mNeighbours.insert(mNeighbours.end(), neighbours.begin(), neighbours.end());
+            mOffsets.push_back(static_cast<std::uint32_t>(mNeighbours.size()));
+        }
+
+        BuildClusters(clusterSize);
+        BuildPortals();
+        BuildTrees(threadCount);
+        BuildAbstractGraph();
+        BuildLandmarks();
+    }
+
+    [[nodiscard]] std::uint32_t RoomCount() const { return mOffsets.empty() ? 0 : static_cast<std::uint32_t>(mOffsets.size() - 1); }
+    [[nodiscard]] std::uint32_t ClusterCount() const { return mClusterOffsets.empty() ? 0 : static_cast<std::uint32_t>(mClusterOffsets.size() - 1); }
+    [[nodiscard]] std::uint32_t PortalCount() const { return static_cast<std::uint32_t>(mPortalRooms.size()); }
+    [[nodiscard]] bool Empty() const { return RoomCount() == 0; }
+
+    [[nodiscard]] std::uint32_t ClusterOf(std::uint32_t room) const { return mClusterOf[room]; }
+    [[nodiscard]] bool IsPortal(std::uint32_t room) const { return mPortalOf[room] != INVALID; }
+    [[nodiscard]] std::span<const std::uint32_t> ClusterRooms(std::uint32_t cluster) const
+    {
+        return std::span<const std::uint32_t>(mClusterRooms).subspan(mClusterOffsets[cluster], mClusterOffsets[cluster + 1] - mClusterOffsets[cluster]);
+    }
+
+    // Length of the path FindPath() would return, without refining it into rooms
+    [[nodiscard]] float Distance(std::uint32_t start, std::uint32_t goal) const
+    {
+        return Search(start, goal, nullptr);
+    }
+
+    // Rooms on the way from start to goal. Within one cluster the local path is used when there is one,
+    // so the result can be longer than the true shortest path, like any HPA* path.
+    [[nodiscard]] Path FindPath(std::uint32_t start, std::uint32_t goal) const
+    {
+        Path path{};
+        path.mLength = Search(start, goal, &path.mRooms);
+        return path;
+    }
+
+    // Brings the hierarchy up to date after the rooms in changed moved or got other corridors, with every room keeping
+    // its index and every other room its position and corridors. changedPositions holds x, y per changed room and
+    // graph is read for the corridors of changed rooms only. Rooms stay on the cluster grid of the first build, the
+    // clusters holding a changed room or one of its neighbours, before or after, get new trees and the others keep theirs.
+    // Outside of the touched clusters the work is copying arrays and lowering the landmark distances that got shorter,
+    // see RepairLandmarks(). Paths stay exact, but many updates can make the search slower than a new build.
+    template <typename Graph>
+    void Update(std::span<const std::uint32_t> changed, std::span<const float> changedPositions, const Graph& graph, unsigned threadCount = 1)
+    {
+        if (Empty() || changed.empty()) {
+            return;
+        }
+
+        std::vector<std::uint32_t> sortedChanged(changed.begin(), changed.end());
+        std::sort(sortedChanged.begin(), sortedChanged.end());
+
+        std::vector<bool> touched(ClusterCount(), false);
+        const auto& touch = [&](std::uint32_t cluster)
+            {
+                if (cluster >= touched.size()) {
+                    touched.resize(cluster + 1, false);
+                }
+                touched[cluster] = true;
+            };
+
+        // Clusters the changed rooms leave and the clusters of their old neighbours
+        std::uint32_t clusterCount = ClusterCount();
+        std::vector<std::uint32_t> moved;
+        for (std::size_t i = 0; i < changed.size(); i++) {
+            const std::uint32_t room = changed[i];
+            touch(mClusterOf[room]);
+            for (std::uint32_t k = mOffsets[room]; k < mOffsets[room + 1]; k++) {
+                touch(mClusterOf[mNeighbours[k]]);
+            }
+
+            if (mPositions[2 * room] != changedPositions[2 * i] || mPositions[2 * room + 1] != changedPositions[2 * i + 1]) {
+                moved.push_back(room);
+            }
+            mPositions[2 * room] = changedPositions[2 * i];
+            mPositions[2 * room + 1] = changedPositions[2 * i + 1];
+            auto& cluster = mCellCluster[CellOf(mPositions[2 * room], mPositions[2 * room + 1])];
+            if (cluster == INVALID) {
+                cluster = clusterCount++;
+            }
+            mClusterOf[room] = cluster;
+            touch(cluster);
+        }
+
+        // Corridors of the unchanged rooms are copied over
+        std::vector<std::uint32_t> offsets, neighbours;
+        offsets.reserve(mOffsets.size());
+        neighbours.reserve(mNeighbours.size());
+        offsets.push_back(0);
+        auto nextChanged = sortedChanged.begin();
+        for (std::uint32_t room = 0; room < RoomCount(); room++) {
+            if (nextChanged != sortedChanged.end() && *nextChanged == room) {
+                for (std::uint32_t neighbour : graph.Neighbours(room)) {
+                    neighbours.push_back(neighbour);
+                    touch(mClusterOf[neighbour]);
+                }
+                for (; nextChanged != sortedChanged.end() && *nextChanged == room; ++nextChanged) {
+                }
+            }
+            else {
+                neighbours.insert(neighbours.end(), mNeighbours.begin() + mOffsets[room], mNeighbours.begin() + mOffsets[room + 1]);
+            }
+            offsets.push_back(static_cast<std::uint32_t>(neighbours.size()));
+        }
+        mOffsets = std::move(offsets);
+        mNeighbours = std::move(neighbours);
+        touched.resize(clusterCount, false);
+
+        const std::uint32_t oldClusterCount = ClusterCount();
+        const std::vector<std::size_t> oldTreeOffsets = std::move(mTreeOffsets);
+        const std::vector<float> oldTreeDistance = std::move(mTreeDistance);
+        const std::vector<std::uint32_t> oldTreeParent = std::move(mTreeParent);
+
+        BuildClusterRooms(clusterCount);
+        BuildPortals();
+
+        // Untouched clusters have the same rooms in the same order and the same portals, so their trees are still valid
+        mTreeDistance.resize(mTreeOffsets.back());
+        mTreeParent.resize(mTreeOffsets.back());
+        std::vector<std::uint32_t> rebuild;
+        for (std::uint32_t cluster = 0; cluster < ClusterCount(); cluster++) {
+            if (cluster < oldClusterCount && !touched[cluster]) {
+                const auto begin = static_cast<std::ptrdiff_t>(oldTreeOffsets[cluster]);
+                const auto end = static_cast<std::ptrdiff_t>(oldTreeOffsets[cluster + 1]);
+                std::copy(oldTreeDistance.begin() + begin, oldTreeDistance.begin() + end, mTreeDistance.begin() + static_cast<std::ptrdiff_t>(mTreeOffsets[cluster]));
+                std::copy(oldTreeParent.begin() + begin, oldTreeParent.begin() + end, mTreeParent.begin() + static_cast<std::ptrdiff_t>(mTreeOffsets[cluster]));
+            }
+            else {
+                rebuild.push_back(cluster);
+            }
+        }
+        ParallelFor(rebuild.size(), threadCount, [&](std::size_t begin, std::size_t end)
+            {
+                std::vector<QueueEntry> heap;
+                for (std::size_t i = begin; i < end; i++) {
+                    BuildTree(rebuild[i], heap);
+                }
+            });
+
+        mAbstractOffsets.clear();
+        mAbstractTargets.clear();
+        mAbstractCosts.clear();
+        BuildAbstractGraph();
+        RepairLandmarks(changed, moved, threadCount);
+    }
+
+    [[nodiscard]] std::size_t MemoryUsage() const
+    {
+        std::size_t bytes = mPositions.capacity() * sizeof(float) + mTreeOffsets.capacity() * sizeof(std::size_t)
+            + mTreeDistance.capacity() * sizeof(float) + mAbstractCosts.capacity() * sizeof(float) + mLandmarkDistance.capacity() * sizeof(float);
+        for (const auto* array : { &mOffsets, &mNeighbours, &mClusterOf, &mClusterOffsets, &mClusterRooms, &mLocalIndex, &mCellCluster,
+            &mPortalOf, &mPortalRooms, &mClusterPortalOffsets, &mTreeParent, &mAbstractOffsets, &mAbstractTargets }) {
+            bytes += array->capacity() * sizeof(std::uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    using QueueEntry = std::pair<float, std::uint32_t>;
+
+    [[nodiscard]] float RoomDistance(std::uint32_t a, std::uint32_t b) const
+    {
+        return std::hypot(mPositions[2 * a] - mPositions[2 * b], mPositions[2 * a + 1] - mPositions[2 * b + 1]);
+    }
+
+    [[nodiscard]] std::uint32_t ClusterSize(std::uint32_t cluster) const { return mClusterOffsets[cluster + 1] - mClusterOffsets[cluster]; }
+
+    // Start of the tree of a portal in mTreeDistance and mTreeParent, indexed by local room index
+    [[nodiscard]] std::size_t TreeRow(std::uint32_t portal) const
+    {
+        const std::uint32_t cluster = mClusterOf[mPortalRooms[portal]];
+        return mTreeOffsets[cluster] + static_cast<std::size_t>(portal - mClusterPortalOffsets[cluster]) * ClusterSize(cluster);
+    }
+
+    [[nodiscard]] float TreeDistance(std::uint32_t portal, std::uint32_t room) const { return mTreeDistance[TreeRow(portal) + mLocalIndex[room]]; }
+
+    // Cell of the cluster grid, positions outside of it go to the nearest border cell
+    [[nodiscard]] std::size_t CellOf(float x, float y) const
+    {
+        const auto cellX = static_cast<std::uint32_t>(std::clamp((x - mGridMinX) / mGridCellSize, 0.0f, static_cast<float>(mGridCellsX - 1)));
+        const auto cellY = static_cast<std::uint32_t>(std::clamp((y - mGridMinY) / mGridCellSize, 0.0f, static_cast<float>(mGridCellsY - 1)));
+        return static_cast<std::size_t>(cellY) * mGridCellsX + cellX;
+    }
+
+    void BuildClusters(float clusterSize)
+    {
+        const std::uint32_t roomCount = RoomCount();
+        if (roomCount == 0) {
+            return;
+        }
+
+        float minX = mPositions[0], minY = mPositions[1], maxX = minX, maxY = minY;
+        for (std::uint32_t room = 1; room < roomCount; room++) {
+            minX = std::min(minX, mPositions[2 * room]);
+            maxX = std::max(maxX, mPositions[2 * room]);
+            minY = std::min(minY, mPositions[2 * room + 1]);
+            maxY = std::max(maxY, mPositions[2 * room + 1]);
+        }
+
+        // Never more cells than rooms, so the cell table stays linear in the size of the dungeon
+        const float area = std::max((maxX - minX) * (maxY - minY), std::numeric_limits<float>::min());
+        const float minimumSize = std::sqrt(area / static_cast<float>(roomCount));
+        if (clusterSize <= 0.0f) {
+            clusterSize = minimumSize * std::sqrt(DEFAULT_CLUSTER_ROOMS);
+        }
+        clusterSize = std::max(clusterSize, minimumSize);
+
+        mGridMinX = minX;
+        mGridMinY = minY;
+        mGridCellSize = clusterSize;
+        mGridCellsX = static_cast<std::uint32_t>((maxX - minX) / clusterSize) + 1;
+        mGridCellsY = static_cast<std::uint32_t>((maxY - minY) / clusterSize) + 1;
+
+        // Clusters are numbered in order of their lowest room
+        mCellCluster.assign(static_cast<std::size_t>(mGridCellsX) * mGridCellsY, INVALID);
+        mClusterOf.resize(roomCount);
+        std::uint32_t clusterCount = 0;
+        for (std::uint32_t room = 0; room < roomCount; room++) {
+            auto& cluster = mCellCluster[CellOf(mPositions[2 * room], mPositions[2 * room + 1])];
+            if (cluster == INVALID) {
+                cluster = clusterCount++;
+            }
+            mClusterOf[room] = cluster;
+        }
+
+        BuildClusterRooms(clusterCount);
+    }
+
+    // Groups the rooms by mClusterOf, ascending within a cluster
+    void BuildClusterRooms(std::uint32_t clusterCount)
+    {
+        const std::uint32_t roomCount = RoomCount();
+        mClusterOffsets.assign(clusterCount + 1, 0);
+        for (std::uint32_t cluster : mClusterOf) {
+            ++mClusterOffsets[cluster + 1];
+        }
+        for (std::uint32_t cluster = 0; cluster < clusterCount; cluster++) {
+            mClusterOffsets[cluster + 1] += mClusterOffsets[cluster];
+        }
+
+        mClusterRooms.resize(roomCount);
+        mLocalIndex.resize(roomCount);
+        std::vector<std::uint32_t> next(mClusterOffsets.begin(), mClusterOffsets.end() - 1);
+        for (std::uint32_t room = 0; room < roomCount; room++) {
+            const std::uint32_t cluster = mClusterOf[room];
+            mLocalIndex[room] = next[cluster] - mClusterOffsets[cluster];
+            mClusterRooms[next[cluster]++] = room;
+        }
+    }
+
+    void BuildPortals()
+    {
+        mPortalRooms.clear();
+        mPortalOf.assign(RoomCount(), INVALID);
+        mClusterPortalOffsets.assign(ClusterCount() + 1, 0);
+        mTreeOffsets.assign(ClusterCount() + 1, 0);
+
+        // Portals are numbered per cluster, so the portals of a cluster are contiguous
+        for (std::uint32_t cluster = 0; cluster < ClusterCount(); cluster++) {
+            for (std::uint32_t room : ClusterRooms(cluster)) {
+                for (std::uint32_t i = mOffsets[room]; i < mOffsets[room + 1]; i++) {
+                    if (mClusterOf[mNeighbours[i]] != cluster) {
+                        mPortalOf[room] = PortalCount();
+                        mPortalRooms.push_back(room);
+                        break;
+                    }
+                }
+            }
+
+            mClusterPortalOffsets[cluster + 1] = PortalCount();
+            const std::uint32_t portals = mClusterPortalOffsets[cluster + 1] - mClusterPortalOffsets[cluster];
+            mTreeOffsets[cluster + 1] = mTreeOffsets[cluster] + static_cast<std::size_t>(portals) * ClusterSize(cluster);
+        }
+    }
+
+    // Dijkstra from every portal over the rooms of its cluster, the clusters are independent
+    void BuildTrees(unsigned threadCount)
+    {
+        mTreeDistance.resize(mTreeOffsets.back());
+        mTreeParent.resize(mTreeOffsets.back());
+
+        ParallelFor(ClusterCount(), threadCount, [&](std::size_t begin, std::size_t end)
+            {
+                std::vector<QueueEntry> heap;
+                for (auto cluster = static_cast<std::uint32_t>(begin); cluster < end; cluster++) {
+                    BuildTree(cluster, heap);
+                }
+            });
+    }
+
+    void BuildTree(std::uint32_t cluster, std::vector<QueueEntry>& heap)
+    {
+        for (std::uint32_t portal = mClusterPortalOffsets[cluster]; portal < mClusterPortalOffsets[cluster + 1]; portal++) {
+            const std::size_t row = TreeRow(portal);
+            LocalSearch(mPortalRooms[portal], std::span(mTreeDistance).subspan(row, ClusterSize(cluster)),
+                std::span(mTreeParent).subspan(row, ClusterSize(cluster)), heap);
+        }
+    }
+
+    // Portals are linked to the portals they reach inside their cluster and to their neighbours in other clusters
+    void BuildAbstractGraph()
+    {
+        mAbstractOffsets.reserve(PortalCount() + 1);
+        mAbstractOffsets.push_back(0);
+
+        for (std::uint32_t portal = 0; portal < PortalCount(); portal++) {
+            const std::uint32_t room = mPortalRooms[portal];
+            const std::uint32_t cluster = mClusterOf[room];
+
+            for (std::uint32_t other = mClusterPortalOffsets[cluster]; other < mClusterPortalOffsets[cluster + 1]; other++) {
+                const float distance = TreeDistance(portal, mPortalRooms[other]);
+                if (other != portal && distance != UNREACHABLE) {
+                    mAbstractTargets.push_back(other);
+                    mAbstractCosts.push_back(distance);
+                }
+            }
+
+            for (std::uint32_t i = mOffsets[room]; i < mOffsets[room + 1]; i++) {
+                const std::uint32_t neighbour = mNeighbours[i];
+                if (mClusterOf[neighbour] != cluster) {
+                    mAbstractTargets.push_back(mPortalOf[neighbour]);
+                    mAbstractCosts.push_back(RoomDistance(room, neighbour));
+                }
+            }
+
+            mAbstractOffsets.push_back(static_cast<std::uint32_t>(mAbstractTargets.size()));
+        }
+    }
+
+    // Landmarks are picked farthest first, each one as far as possible from the ones before it
+    void BuildLandmarks()
+    {
+        const std::uint32_t roomCount = RoomCount();
+        if (roomCount == 0) {
+            return;
+        }
+
+        mLandmarkDistance.assign(static_cast<std::size_t>(roomCount) * LANDMARK_COUNT, UNREACHABLE);
+        std::vector<float> distance(roomCount), nearest(roomCount, UNREACHABLE);
+        std::vector<QueueEntry> heap;
+
+        // The room farthest from room 0 is the first landmark
+        FullSearch(0, distance, heap);
+        std::uint32_t landmark = Farthest(distance);
+
+        for (std::uint32_t i = 0; i < LANDMARK_COUNT; i++) {
+            FullSearch(landmark, distance, heap);
+            for (std::uint32_t room = 0; room < roomCount; room++) {
+                mLandmarkDistance[static_cast<std::size_t>(room) * LANDMARK_COUNT + i] = distance[room];
+                nearest[room] = std::min(nearest[room], distance[room]);
+            }
+            landmark = Farthest(nearest);
+        }
+    }
+
+    // The heuristic only needs landmark distances that differ by at most the length of any corridor, true distances
+    // are just the tightest choice. After an update the moved rooms take theirs from their new neighbours, and
+    // rooms that a changed room brings closer to a landmark are lowered, searching outwards only as far as that goes.
+    // Rooms that end up farther from a landmark keep their old distance, a weaker but still valid bound.
+    void RepairLandmarks(std::span<const std::uint32_t> changed, std::span<const std::uint32_t> moved, unsigned threadCount)
+    {
+        ParallelFor(LANDMARK_COUNT, threadCount, [&](std::size_t begin, std::size_t end)
+            {
+                std::vector<QueueEntry> heap;
+                for (std::size_t i = begin; i < end; i++) {
+                    const auto& distance = [&](std::uint32_t room) -> float& { return mLandmarkDistance[static_cast<std::size_t>(room) * LANDMARK_COUNT + i]; };
+                    for (std::uint32_t room : moved) {
+                        distance(room) = UNREACHABLE;
+                    }
+
+                    heap.clear();
+                    for (std::uint32_t room : changed) {
+                        if (distance(room) != UNREACHABLE) {
+                            heap.emplace_back(distance(room), room);
+                        }
+                    }
+                    std::make_heap(heap.begin(), heap.end(), std::greater<>{});
+
+                    while (!heap.empty()) {
+                        std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+                        const auto [current, room] = heap.back();
+                        heap.pop_back();
+                        if (current > distance(room)) {
+                            continue;
+                        }
+
+                        for (std::uint32_t k = mOffsets[room]; k < mOffsets[room + 1]; k++) {
+                            const std::uint32_t neighbour = mNeighbours[k];
+                            const float next = current + RoomDistance(room, neighbour);
+                            if (next < distance(neighbour)) {
+                                distance(neighbour) = next;
+                                heap.emplace_back(next, neighbour);
+                                std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+                            }
+                        }
+                    }
+                }
+            });
+    }
+
+    // Room with the largest finite distance, the lowest one on ties
+    [[nodiscard]] static std::uint32_t Farthest(std::span<const float> distance)
+    {
+        std::uint32_t farthest = 0;
+        for (std::uint32_t room = 0; room < distance.size(); room++) {
+            if (distance[room] != UNREACHABLE && (distance[farthest] == UNREACHABLE || distance[room] > distance[farthest])) {
+                farthest = room;
+            }
+        }
+        return farthest;
+    }
+
+    void FullSearch(std::uint32_t source, std::span<float> distance, std::vector<QueueEntry>& heap) const
+    {
+        std::fill(distance.begin(), distance.end(), UNREACHABLE);
+        heap.clear();
+        distance[source] = 0.0f;
+        heap.emplace_back(0.0f, source);
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto [current, room] = heap.back();
+            heap.pop_back();
+            if (current > distance[room]) {
+                continue;
+            }
+
+            for (std::uint32_t i = mOffsets[room]; i < mOffsets[room + 1]; i++) {
+                const std::uint32_t neighbour = mNeighbours[i];
+                const float next = current + RoomDistance(room, neighbour);
+                if (next < distance[neighbour]) {
+                    distance[neighbour] = next;
+                    heap.emplace_back(next, neighbour);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+                }
+            }
+        }
+    }
+
+    // Lower bound on the distance between two rooms, from the triangle inequality on every landmark
+    [[nodiscard]] float Heuristic(std::uint32_t room, std::uint32_t goal) const
+    {
+        float bound = RoomDistance(room, goal);
+        const float* fromRoom = &mLandmarkDistance[static_cast<std::size_t>(room) * LANDMARK_COUNT];
+        const float* fromGoal = &mLandmarkDistance[static_cast<std::size_t>(goal) * LANDMARK_COUNT];
+        for (std::uint32_t i = 0; i < LANDMARK_COUNT; i++) {
+            if (fromRoom[i] != UNREACHABLE && fromGoal[i] != UNREACHABLE) {
+                bound = std::max(bound, std::abs(fromRoom[i] - fromGoal[i]));
+            }
+        }
+        return bound;
+    }
+
+    // Dijkstra from source without leaving its cluster, distance and parent are indexed by local room index
+    void LocalSearch(std::uint32_t source, std::span<float> distance, std::span<std::uint32_t> parent, std::vector<QueueEntry>& heap) const
+    {
+        const std::uint32_t cluster = mClusterOf[source];
+        std::fill(distance.begin(), distance.end(), UNREACHABLE);
+        std::fill(parent.begin(), parent.end(), INVALID);
+
+        heap.clear();
+        distance[mLocalIndex[source]] = 0.0f;
+        heap.emplace_back(0.0f, source);
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto [current, room] = heap.back();
+            heap.pop_back();
+            if (current > distance[mLocalIndex[room]]) {
+                continue;
+            }
+
+            for (std::uint32_t i = mOffsets[room]; i < mOffsets[room + 1]; i++) {
+                const std::uint32_t neighbour = mNeighbours[i];
+                if (mClusterOf[neighbour] != cluster) {
+                    continue;
+                }
+
+                const float next = current + RoomDistance(room, neighbour);
+                if (next < distance[mLocalIndex[neighbour]]) {
+                    distance[mLocalIndex[neighbour]] = next;
+                    parent[mLocalIndex[neighbour]] = mLocalIndex[room];
+                    heap.emplace_back(next, neighbour);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+                }
+            }
+        }
+    }
+
+    // Appends room and its parents up to the root of the tree, which lies in the same cluster
+    void AppendTreePath(std::span<const std::uint32_t> parent, std::uint32_t room, std::vector<std::uint32_t>& rooms) const
+    {
+        const std::uint32_t first = mClusterOffsets[mClusterOf[room]];
+        for (std::uint32_t local = mLocalIndex[room]; local != INVALID; local = parent[local]) {
+            rooms.push_back(mClusterRooms[first + local]);
+        }
+    }
+
+    [[nodiscard]] std::span<const std::uint32_t> TreeParents(std::uint32_t portal) const
+    {
+        return std::span<const std::uint32_t>(mTreeParent).subspan(TreeRow(portal), ClusterSize(mClusterOf[mPortalRooms[portal]]));
+    }
+
+    // A* over the portals, with the start and goal linked to the portals of their clusters.
+    // Fills rooms with the refined path when it is given.
+    float Search(std::uint32_t start, std::uint32_t goal, std::vector<std::uint32_t>* rooms) const
+    {
+        if (start >= RoomCount() || goal >= RoomCount()) {
+            return UNREACHABLE;
+        }
+
+        // Scratch reused between queries on the same thread, nodes are only valid when stamped with the current query
+        thread_local std::vector<QueueEntry> heap;
+        thread_local std::vector<float> cost;
+        thread_local std::vector<std::uint32_t> parent;
+        thread_local std::vector<std::uint32_t> stamp;
+        thread_local std::uint32_t currentStamp = 0;
+
+        const std::uint32_t startCluster = mClusterOf[start];
+        const std::uint32_t goalCluster = mClusterOf[goal];
+        if (startCluster == goalCluster) {
+            const std::uint32_t size = ClusterSize(startCluster);
+            cost.resize(std::max<std::size_t>(cost.size(), size));
+            parent.resize(std::max<std::size_t>(parent.size(), size));
+            LocalSearch(goal, std::span(cost).first(size), std::span(parent).first(size), heap);
+
+            // This overwrites cost and parent without stamping them, every portal search below starts with a new stamp
+            const float length = cost[mLocalIndex[start]];
+            if (length != UNREACHABLE) {
+                if (rooms) {
+                    AppendTreePath(std::span(parent).first(size), start, *rooms);
+                }
+                return length;
+            }
+        }
+
+        // Nodes are the portals, then the start and the goal
+        const std::uint32_t startNode = PortalCount();
+        const std::uint32_t goalNode = PortalCount() + 1;
+        if (stamp.size() < goalNode + 1) {
+            cost.resize(std::max<std::size_t>(cost.size(), goalNode + 1));
+            parent.resize(std::max<std::size_t>(parent.size(), goalNode + 1));
+            stamp.resize(goalNode + 1, 0);
+        }
+        if (++currentStamp == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            currentStamp = 1;
+        }
+
+        const auto& nodeRoom = [&](std::uint32_t node) { return node == startNode ? start : node == goalNode ? goal : mPortalRooms[node]; };
+        const auto& nodeCost = [&](std::uint32_t node) { return stamp[node] == currentStamp ? cost[node] : UNREACHABLE; };
+        const auto& relax = [&](std::uint32_t from, std::uint32_t to, float edgeCost)
+            {
+                const float nextCost = cost[from] + edgeCost;
+                if (nextCost < nodeCost(to)) {
+                    stamp[to] = currentStamp;
+                    cost[to] = nextCost;
+                    parent[to] = from;
+                    heap.emplace_back(nextCost + Heuristic(nodeRoom(to), goal), to);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+                }
+            };
+
+        heap.clear();
+        stamp[startNode] = currentStamp;
+        cost[startNode] = 0.0f;
+        parent[startNode] = INVALID;
+        heap.emplace_back(Heuristic(start, goal), startNode);
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto [estimate, node] = heap.back();
+            heap.pop_back();
+
+            if (node == goalNode) {
+                break;
+            }
+            const std::uint32_t room = nodeRoom(node);
+            if (estimate > cost[node] + Heuristic(room, goal)) {
+                continue;
+            }
+
+            if (node == startNode) {
+                for (std::uint32_t portal = mClusterPortalOffsets[startCluster]; portal < mClusterPortalOffsets[startCluster + 1]; portal++) {
+                    const float distance = TreeDistance(portal, start);
+                    if (distance != UNREACHABLE) {
+                        relax(node, portal, distance);
+                    }
+                }
+                continue;
+            }
+
+            for (std::uint32_t i = mAbstractOffsets[node]; i < mAbstractOffsets[node + 1]; i++) {
+                relax(node, mAbstractTargets[i], mAbstractCosts[i]);
+            }
+            if (mClusterOf[room] == goalCluster && TreeDistance(node, goal) != UNREACHABLE) {
+                relax(node, goalNode, TreeDistance(node, goal));
+            }
+        }
+
+        const float length = nodeCost(goalNode);
+        if (length == UNREACHABLE || !rooms) {
+            return length;
+        }
+
+        // Portals from the last to the first
+        std::vector<std::uint32_t> portals;
+        for (std::uint32_t node = parent[goalNode]; node != startNode; node = parent[node]) {
+            portals.push_back(node);
+        }
+
+        // The tree of a portal leads from any room of its cluster to the portal. Hops between clusters are single corridors.
+        AppendTreePath(TreeParents(portals.back()), start, *rooms);
+        for (std::size_t i = portals.size() - 1; i > 0; i--) {
+            const std::uint32_t from = portals[i];
+            const std::uint32_t to = portals[i - 1];
+            if (mClusterOf[mPortalRooms[from]] != mClusterOf[mPortalRooms[to]]) {
+                rooms->push_back(mPortalRooms[to]);
+            }
+            else {
+                const std::size_t begin = rooms->size();
+                AppendTreePath(TreeParents(to), mPortalRooms[from], *rooms);
+                rooms->erase(rooms->begin() + static_cast<std::ptrdiff_t>(begin));
+            }
+        }
+
+        const std::size_t begin = rooms->size();
+        AppendTreePath(TreeParents(portals.front()), goal, *rooms);
+        rooms->pop_back();
+        std::reverse(rooms->begin() + static_cast<std::ptrdiff_t>(begin), rooms->end());
+
+        return length;
+    }
+
+    std::vector<float> mPositions{}; // Interleaved x, y
+    std::vector<std::uint32_t> mOffsets{}; // Room connectivity in compressed sparse row form
+    std::vector<std::uint32_t> mNeighbours{};
+
+    std::vector<std::uint32_t> mClusterOf{};
+    std::vector<std::uint32_t> mClusterOffsets{};
+    std::vector<std::uint32_t> mClusterRooms{}; // Rooms grouped per cluster, ascending within a cluster
+    std::vector<std::uint32_t> mLocalIndex{}; // Position of a room within its cluster
+
+    float mGridMinX = 0.0f; // Square cells of mGridCellSize, each one cluster
+    float mGridMinY = 0.0f;
+    float mGridCellSize = 1.0f;
+    std::uint32_t mGridCellsX = 0;
+    std::uint32_t mGridCellsY = 0;
+    std::vector<std::uint32_t> mCellCluster{}; // INVALID for cells that never held a room
+
+    std::vector<std::uint32_t> mPortalOf{}; // INVALID for rooms without a corridor into another cluster
+    std::vector<std::uint32_t> mPortalRooms{};
+    std::vector<std::uint32_t> mClusterPortalOffsets{};
+
+    std::vector<std::size_t> mTreeOffsets{}; // Start of the portals x rooms block of each cluster
+    std::vector<float> mTreeDistance{};
+    std::vector<std::uint32_t> mTreeParent{}; // Local room index, INVALID at the portal
+
+    std::vector<std::uint32_t> mAbstractOffsets{}; // Portal graph in compressed sparse row form
+    std::vector<std::uint32_t> mAbstractTargets{};
+    std::vector<float> mAbstractCosts{};
+
+    std::vector<float> mLandmarkDistance{}; // LANDMARK_COUNT distances per room
+};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace DungeonGenerator
+{
+
+// Uniform grid over a square with the points of every cell in a linked list, for spacing and nearest point queries
+class PointGrid
+{
+public:
+    static constexpr std::uint32_t INVALID = std::numeric_limits<std::uint32_t>::max();
+
+    PointGrid(float minX, float minY, float extent, float cellSize)
+        : mMinX(minX), mMinY(minY), mCellSize(cellSize),
+          mWidth(std::max(1, static_cast<int>(std::ceil(extent / cellSize)))),
+          mHeads(static_cast<std::size_t>(mWidth) * static_cast<std::size_t>(mWidth), INVALID)
+    {}
+
+    void Insert(float x, float y)
+    {
+        const std::size_t cell = Cell(CellCoordinate(x, mMinX), CellCoordinate(y, mMinY));
+        mPoints.push_back({ x, y });
+        mNext.push_back(mHeads[cell]);
+        mHeads[cell] = static_cast<std::uint32_t>(mPoints.size() - 1);
+    }
+
+    // True when no point lies closer than distance, which must not exceed the cell size
+    [[nodiscard]] bool Free(float x, float y, float distance) const
+    {
+        const int cx = CellCoordinate(x, mMinX), cy = CellCoordinate(y, mMinY);
+        for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, mWidth - 1); gy++) {
+            for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, mWidth - 1); gx++) {
+                for (std::uint32_t i = mHeads[Cell(gx, gy)]; i != INVALID; i = mNext[i]) {
+                    const float dx = mPoints[i].mX - x, dy = mPoints[i].mY - y;
+                    if (dx * dx + dy * dy < distance * distance) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // Index of the closest point in insertion order, searching rings of cells outwards
+    [[nodiscard]] std::uint32_t Nearest(float x, float y) const
+    {
+        const int cx = CellCoordinate(x, mMinX), cy = CellCoordinate(y, mMinY);
+        std::uint32_t best = INVALID;
+        float bestDistance = std::numeric_limits<float>::max();
+        for (int ring = 0; ring < mWidth; ring++) {
+            // Every point further out is at least (ring - 1) cells away
+            const float ringDistance = static_cast<float>(ring - 1) * mCellSize;
+            if (best != INVALID && ring > 1 && ringDistance * ringDistance > bestDistance) {
+                break;
+            }
+            for (int gy = cy - ring; gy <= cy + ring; gy++) {
+                for (int gx = cx - ring; gx <= cx + ring; gx++) {
+                    const bool onRing = gy == cy - ring || gy == cy + ring || gx == cx - ring || gx == cx + ring;
+                    if (!onRing || gx < 0 || gy < 0 || gx >= mWidth || gy >= mWidth) {
+                        continue;
+                    }
+                    for (std::uint32_t i = mHeads[Cell(gx, gy)]; i != INVALID; i = mNext[i]) {
+                        const float dx = mPoints[i].mX - x, dy = mPoints[i].mY - y;
+                        if (dx * dx + dy * dy < bestDistance) {
+                            bestDistance = dx * dx + dy * dy;
+                            best = i;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    struct Point
+    {
+        float mX;
+        float mY;
+    };
+
+    [[nodiscard]] int CellCoordinate(float value, float min) const
+    {
+        return std::clamp(static_cast<int>((value - min) / mCellSize), 0, mWidth - 1);
+    }
+    [[nodiscard]] std::size_t Cell(int x, int y) const
+    {
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(mWidth) + static_cast<std::size_t>(x);
+    }
+
+    float mMinX;
+    float mMinY;
+    float mCellSize;
+    int mWidth;
+    std::vector<std::uint32_t> mHeads;
+    std::vector<std::uint32_t> mNext{};
+    std::vector<Point> mPoints{};
+};
+
+}
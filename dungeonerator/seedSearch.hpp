@@ -0,0 +1,148 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace DungeonGenerator
+{
+
+// Checked right after mStage on the dungeon as far as it is generated by then: the rooms after COORDINATES,
+// the spanning tree after MST, every corridor after LOOPS, types and difficulty after CONTENT and
+// Dungeon::mMetrics after METRICS. Predicates run concurrently on different dungeons.
+struct SeedConstraint
+{
+    GenerationStage mStage = GenerationStage::CONTENT;
+    std::function<bool(const Dungeon&)> mPredicate{};
+};
+
+struct SeedSearchSettings
+{
+    int mFirstSeed = 1; // Seeds are tried upwards from here, up to the largest int at most
+    std::size_t mMaxCandidates = 10000;
+    std::size_t mResultCount = 1;
+    unsigned mThreadCount = 0; // 0 uses every hardware thread, the result is the same for any count
+    std::size_t mSeedsPerThread = 4; // How far per thread the candidates may run ahead of the lowest unfinished seed
+};
+
+struct SeedSearchResult
+{
+    std::vector<int> mSeeds{}; // The first mResultCount passing seeds, ascending
+    std::size_t mCandidates = 0; // Seeds up to the last passing one, or every seed tried when too few passed
+    std::array<std::size_t, static_cast<std::size_t>(GenerationStage::NUM_STAGES)> mRejections{}; // Among mCandidates, per stage
+};
+
+namespace SeedSearchDetail
+{
+    constexpr auto PASSED = GenerationStage::NUM_STAGES;
+
+    // Stops the generation at the first failing constraint, or after the last constrained stage when all pass
+    struct ConstraintSink : DungeonSink
+    {
+        std::span<const SeedConstraint> mConstraints;
+        GenerationStage mLastStage;
+        GenerationStage& mOutcome;
+
+        // The candidates already keep every thread busy
+        unsigned ThreadCount() const { return 1; }
+
+        bool StageCompleted(GenerationStage stage) const
+        {
+            for (const auto& constraint : mConstraints) {
+                if (constraint.mStage == stage && !constraint.mPredicate(mDungeon)) {
+                    mOutcome = stage;
+                    return false;
+                }
+            }
+            if (stage == mLastStage) {
+                mOutcome = PASSED;
+                return false;
+            }
+            return true;
+        }
+    };
+}
+
+// Generates candidates for consecutive seeds on several threads and returns the first seeds that pass every constraint.
+// Every thread takes the next seed as soon as it is done with one, and the outcomes are counted in seed order as they
+// come in, so the search stops right after the last seed it needs. A candidate is dropped at the first stage with a
+// failing constraint and never runs the stages after the last constrained one. The navmesh and the path hierarchy are
+// only built for constraints on their stages and metrics only for constraints on METRICS, none of them changes the
+// rooms or corridors of a seed.
+inline SeedSearchResult SearchSeeds(const GenerationData& generationData, std::span<const SeedConstraint> constraints, const SeedSearchSettings& settings = {})
+{
+    SeedSearchResult result{};
+    if (settings.mResultCount == 0) {
+        return result;
+    }
+
+    GenerationData data = generationData;
+    const auto& constrains = [&](GenerationStage stage)
+        {
+            return std::any_of(constraints.begin(), constraints.end(), [&](const SeedConstraint& constraint) { return constraint.mStage == stage; });
+        };
+    data.mBuildNavMesh = data.mBuildNavMesh && constrains(GenerationStage::NAVMESH);
+    data.mBuildPathHierarchy = data.mBuildPathHierarchy && constrains(GenerationStage::HIERARCHY);
+    data.mComputeMetrics = constrains(GenerationStage::METRICS);
+
+    GenerationStage lastStage = GenerationStage::POISSON;
+    for (const auto& constraint : constraints) {
+        lastStage = std::max(lastStage, constraint.mStage);
+    }
+
+    const unsigned threadCount = std::max(settings.mThreadCount == 0 ? std::thread::hardware_concurrency() : settings.mThreadCount, 1u);
+    const std::int64_t firstSeed = settings.mFirstSeed;
+    const std::size_t candidateCount = static_cast<std::size_t>(std::clamp<std::int64_t>(std::numeric_limits<int>::max() - firstSeed + 1,
+        0, static_cast<std::int64_t>(std::min<std::size_t>(settings.mMaxCandidates, std::numeric_limits<int>::max()))));
+
+    // Outcomes of the candidates from the lowest unfinished one on, a thread waits before it runs further ahead
+    const std::size_t window = threadCount * std::max<std::size_t>(settings.mSeedsPerThread, 1);
+    std::vector<GenerationStage> outcomes(window);
+    std::vector<bool> finished(window, false);
+    std::size_t counted = 0;
+    bool done = false;
+    std::mutex mutex;
+    std::condition_variable windowMoved;
+
+    ParallelForEach(candidateCount, threadCount, [&](std::size_t i)
+        {
+            {
+                std::unique_lock lock(mutex);
+                windowMoved.wait(lock, [&]() { return done || i < counted + window; });
+                if (done) {
+                    return false;
+                }
+            }
+
+            Dungeon dungeon;
+            dungeon.mGenerationData = data;
+            dungeon.mGenerationData.mSeed = static_cast<int>(firstSeed + static_cast<std::int64_t>(i));
+            GenerationStage outcome = SeedSearchDetail::PASSED;
+            SeedSearchDetail::ConstraintSink sink{ { dungeon }, constraints, lastStage, outcome };
+            GenerateInto(dungeon.mGenerationData, sink);
+
+            std::lock_guard lock(mutex);
+            outcomes[i % window] = outcome;
+            finished[i % window] = true;
+
+            // In seed order, so the result does not depend on the threads
+            for (; !done && counted < candidateCount && finished[counted % window]; counted++) {
+                const std::size_t slot = counted % window;
+                finished[slot] = false;
+                ++result.mCandidates;
+                if (outcomes[slot] != SeedSearchDetail::PASSED) {
+                    ++result.mRejections[static_cast<std::size_t>(outcomes[slot])];
+                    continue;
+                }
+                result.mSeeds.push_back(static_cast<int>(firstSeed + static_cast<std::int64_t>(counted)));
+                done = result.mSeeds.size() == settings.mResultCount;
+            }
+            windowMoved.notify_all();
+            return !done;
+        });
+
+    return result;
+}
+
+}
@@ -0,0 +1,50 @@
+#include "alias_table.hpp"
+
+AliasTable::AliasTable(std::span<const float> weights)
+    : _weights(weights.begin(), weights.end()) {
+    double total = 0.0;
+    for (float weight : weights) {
+        total += weight > 0.0f ? weight : 0.0f;
+    }
+
+    if (weights.empty() || total <= 0.0) {
+        return;
+    }
+
+    const size_t n = weights.size();
+    _probability.resize(n);
+    _alias.resize(n);
+
+    // Scale so the average column holds exactly 1
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (uint32_t i = 0; i < n; i++) {
+        scaled[i] = (weights[i] > 0.0f ? weights[i] : 0.0) * static_cast<double>(n) / total;
+        (scaled[i] < 1.0 ? small : large).emplace_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const uint32_t less = small.back();
+        small.pop_back();
+        const uint32_t more = large.back();
+
+        _probability[less] = static_cast<float>(scaled[less]);
+        _alias[less] = more;
+
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) {
+            large.pop_back();
+            small.emplace_back(more);
+        }
+    }
+
+    // Leftovers are full columns up to rounding errors
+    for (uint32_t i : large) {
+        _probability[i] = 1.0f;
+        _alias[i] = i;
+    }
+    for (uint32_t i : small) {
+        _probability[i] = 1.0f;
+        _alias[i] = i;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+// Walker/Vose alias table, samples an index proportional to its weight in O(1)
+class AliasTable {
+public:
+    AliasTable() = default;
+    explicit AliasTable(std::span<const float> weights);
+
+    [[nodiscard]] bool Empty() const { return _probability.empty(); }
+    [[nodiscard]] float Weight(uint32_t i) const { return _weights[i]; }
+
+    template <typename RNG>
+    uint32_t Sample(RNG& rng) const {
+        const auto column = static_cast<uint32_t>(rng() % _probability.size());
+        const float coin = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+        return coin < _probability[column] ? column : _alias[column];
+    }
+
+private:
+    std::vector<float> _weights {};
+    std::vector<float> _probability {};
+    std::vector<uint32_t> _alias {};
+};
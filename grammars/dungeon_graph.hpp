@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "dungeonerator.hpp"
+#include "graph.hpp"
+
+// Read-only graph over the arrays of a Dungeon, nothing is copied.
+// Vertices are the indices into mVertices and edges the indices into mEdges, the dungeon has to outlive the view.
+class DungeonGraphView {
+public:
+    using Index = uint32_t;
+
+    explicit DungeonGraphView(const DungeonGenerator::Dungeon& dungeon)
+        : _dungeon(&dungeon) {
+    }
+
+    [[nodiscard]] size_t VertexCount() const { return _dungeon->mVertices.size(); }
+    [[nodiscard]] size_t EdgeCount() const { return _dungeon->mEdges.size(); }
+    [[nodiscard]] bool Contains(Index v) const { return v < _dungeon->mVertices.size(); }
+
+    [[nodiscard]] const DungeonGenerator::DungeonVertex& GetVertex(Index v) const { return _dungeon->mVertices[v]; }
+    [[nodiscard]] const DungeonGenerator::DungeonEdge& GetEdge(Index e) const { return _dungeon->mEdges[e]; }
+
+    [[nodiscard]] std::span<const Index> Neighbours(Index v) const { return _dungeon->mVertices[v].mConnections; }
+    [[nodiscard]] size_t Degree(Index v) const { return _dungeon->mVertices[v].mConnections.size(); }
+
+    [[nodiscard]] std::span<const DungeonGenerator::DungeonVertex> Vertices() const { return _dungeon->mVertices; }
+    [[nodiscard]] std::span<const DungeonGenerator::DungeonEdge> Edges() const { return _dungeon->mEdges; }
+
+private:
+    const DungeonGenerator::Dungeon* _dungeon;
+};
+
+// Copies a dungeon into a Graph, for passes that modify the graph. Read-only passes should use DungeonGraphView.
+// vertexData(const DungeonVertex&, index) and edgeData(const DungeonEdge&, index) build the stored data.
+// Returns the VertexId of every dungeon vertex.
+template <typename vertexType, typename edgeType, typename VertexFn, typename EdgeFn>
+std::vector<VertexId> ToGraph(const DungeonGenerator::Dungeon& dungeon, Graph<vertexType, edgeType>& graph, VertexFn vertexData, EdgeFn edgeData)
+{
+    graph.Reserve(graph.VertexCount() + dungeon.mVertices.size(), graph.EdgeCount() + dungeon.mEdges.size());
+
+    std::vector<vertexType> vertices;
+    vertices.reserve(dungeon.mVertices.size());
+    for (uint32_t i = 0; i < dungeon.mVertices.size(); i++) {
+        vertices.emplace_back(vertexData(dungeon.mVertices[i], i));
+    }
+    std::vector<VertexId> ids = graph.AddVertices(vertices);
+
+    std::vector<std::pair<VertexId, VertexId>> endpoints;
+    std::vector<edgeType> edges;
+    endpoints.reserve(dungeon.mEdges.size());
+    edges.reserve(dungeon.mEdges.size());
+    for (uint32_t i = 0; i < dungeon.mEdges.size(); i++) {
+        const auto& edge = dungeon.mEdges[i];
+        endpoints.emplace_back(ids[edge.mNode1], ids[edge.mNode2]);
+        edges.emplace_back(edgeData(edge, i));
+    }
+    graph.AddEdges(endpoints, edges);
+    graph.Finalize();
+
+    return ids;
+}
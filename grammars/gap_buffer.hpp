@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+// Contiguous sequence with a movable hole, edits near the previous edit only move the elements in between.
+// Replacing k elements costs O(k + distance to the previous edit), so localized rewriting is amortized O(k).
+template <typename T>
+class GapBuffer {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    GapBuffer() = default;
+
+    explicit GapBuffer(std::span<const T> values) {
+        Assign(values);
+    }
+
+    void Assign(std::span<const T> values) {
+        _data.assign(values.begin(), values.end());
+        _data.resize(std::max<size_t>(values.size() * 2, MIN_GAP));
+        _gapStart = values.size();
+        _gapEnd = _data.size();
+    }
+
+    [[nodiscard]] size_t Size() const { return _data.size() - GapSize(); }
+    [[nodiscard]] bool Empty() const { return Size() == 0; }
+
+    [[nodiscard]] const T& operator[](size_t i) const {
+        return i < _gapStart ? _data[i] : _data[i + GapSize()];
+    }
+
+    // First index at or after from where pattern starts, npos when there is none
+    [[nodiscard]] size_t Find(std::span<const T> pattern, size_t from = 0) const {
+        const size_t m = pattern.size();
+        if (m == 0 || m > Size() || from > Size() - m) {
+            return npos;
+        }
+
+        // Matches that lie completely before the gap
+        if (from < _gapStart) {
+            const auto end = _data.begin() + static_cast<std::ptrdiff_t>(_gapStart);
+            const auto it = std::search(_data.begin() + static_cast<std::ptrdiff_t>(from), end, pattern.begin(), pattern.end());
+            if (it != end) {
+                return static_cast<size_t>(it - _data.begin());
+            }
+        }
+
+        // Matches straddling the gap
+        const size_t straddleBegin = std::max(from, _gapStart >= m ? _gapStart - m + 1 : 0);
+        for (size_t i = straddleBegin; i < _gapStart && i + m <= Size(); i++) {
+            size_t j = 0;
+            while (j < m && (*this)[i + j] == pattern[j]) {
+                ++j;
+            }
+            if (j == m) {
+                return i;
+            }
+        }
+
+        // Matches that lie completely after the gap
+        const size_t afterFrom = std::max(from, _gapStart) + GapSize();
+        const auto it = std::search(_data.begin() + static_cast<std::ptrdiff_t>(afterFrom), _data.end(), pattern.begin(), pattern.end());
+        if (it != _data.end()) {
+            return static_cast<size_t>(it - _data.begin()) - GapSize();
+        }
+
+        return npos;
+    }
+
+    // Replaces count elements starting at pos with the replacement
+    void Replace(size_t pos, size_t count, std::span<const T> replacement) {
+        MoveGap(pos);
+        _gapEnd += count; // The replaced elements now directly follow the gap, swallow them
+
+        if (replacement.size() > GapSize()) {
+            Grow(replacement.size());
+        }
+
+        std::copy(replacement.begin(), replacement.end(), _data.begin() + static_cast<std::ptrdiff_t>(_gapStart));
+        _gapStart += replacement.size();
+    }
+
+    // Closes the gap by moving it to the back, the elements are then contiguous
+    std::span<const T> Data() {
+        MoveGap(Size());
+        return std::span<const T>(_data.data(), _gapStart);
+    }
+
+    [[nodiscard]] size_t MemoryUsage() const { return _data.capacity() * sizeof(T); }
+
+private:
+    static constexpr size_t MIN_GAP = 16;
+
+    [[nodiscard]] size_t GapSize() const { return _gapEnd - _gapStart; }
+
+    void MoveGap(size_t pos) {
+        if (pos < _gapStart) {
+            const size_t count = _gapStart - pos;
+            std::move_backward(_data.begin() + static_cast<std::ptrdiff_t>(pos), _data.begin() + static_cast<std::ptrdiff_t>(_gapStart),
+                _data.begin() + static_cast<std::ptrdiff_t>(_gapEnd));
+            _gapStart -= count;
+            _gapEnd -= count;
+        } else if (pos > _gapStart) {
+            const size_t count = pos - _gapStart;
+            std::move(_data.begin() + static_cast<std::ptrdiff_t>(_gapEnd), _data.begin() + static_cast<std::ptrdiff_t>(_gapEnd + count),
+                _data.begin() + static_cast<std::ptrdiff_t>(_gapStart));
+            _gapStart += count;
+            _gapEnd += count;
+        }
+    }
+
+    // Doubles the storage so the gap can hold at least required elements
+    void Grow(size_t required) {
+        const size_t tail = _data.size() - _gapEnd;
+        const size_t newSize = std::max(_data.size() * 2, Size() + required + MIN_GAP);
+
+        _data.resize(newSize);
+        std::move_backward(_data.begin() + static_cast<std::ptrdiff_t>(_gapEnd), _data.begin() + static_cast<std::ptrdiff_t>(_gapEnd + tail),
+            _data.end());
+        _gapEnd = newSize - tail;
+    }
+
+    std::vector<T> _data{};
+    size_t _gapStart = 0;
+    size_t _gapEnd = 0;
+};
@@ -1,6 +1,9 @@
 #include "grammar.hpp"
+#include "occurrence_index.hpp"
+#include "parallelFor.hpp"
+#include <algorithm>
 #include <random>
-#include <set>
+#include <thread>
 #include <iostream>
 
 void Grammar::PrintInfo() const {
@@ -35,36 +38,130 @@ void Grammar::PrintInfo() const {
     }
 }
 
-void Grammar::ExecuteGrammar(const std::list<SymbolID>& startString) {
-    // restrict depth to 1000
-    uint32_t depth = 0;
-    std::random_device rd;
-    std::mt19937 mt(rd());
-    std::uniform_int_distribution<uint32_t> dist(_rules.size());
-    std::set<size_t> badRules = {};
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
 
-    _outputString = std::list<SymbolID>(startString.begin(),startString.end());
+}
+
+void Grammar::ExecuteGrammar(std::span<const SymbolID> startString, const ExecutionSettings& settings) {
+    RNG rng(settings.seed.has_value() ? *settings.seed : std::random_device{}());
 
-    while (depth < 1000 && badRules.size() !=  _rules.size()) {
-        auto idx = dist(mt) % _rules.size();
+    std::vector<SymbolID> output;
+    Execute(startString, settings, rng, output);
+    _outputString.Assign(output);
+}
+
+std::vector<std::vector<Grammar::SymbolID>> Grammar::ExecuteBatch(std::span<const std::vector<SymbolID>> startStrings,
+    uint64_t seed, const ExecutionSettings& settings, unsigned threadCount) const {
+    std::vector<std::vector<SymbolID>> results(startStrings.size());
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    DungeonGenerator::ParallelForEach(startStrings.size(), threadCount, [&](size_t i) {
+        results[i] = Expand(startStrings[i], seed + i, settings);
+    });
+
+    return results;
+}
+
+std::vector<Grammar::SymbolID> Grammar::Expand(std::span<const SymbolID> startString, uint64_t seed, const ExecutionSettings& settings) const {
+    RNG rng(SplitMix64(seed));
+    std::vector<SymbolID> output;
+    Execute(startString, settings, rng, output);
+    return output;
+}
+
+void Grammar::Execute(std::span<const SymbolID> startString, const ExecutionSettings& settings, RNG& rng, std::vector<SymbolID>& output) const {
+    if (settings.mode == ExecutionMode::INDEXED) {
+        OccurrenceIndex index(_matcher);
+        index.Assign(startString);
+        ExecuteIndexed(index, settings.maxSteps, rng);
+        index.CopyTo(output);
+    } else {
+        GapBuffer<SymbolID> string(startString);
+        ExecuteSearch(string, settings.maxSteps, rng);
+        const auto data = string.Data();
+        output.assign(data.begin(), data.end());
+    }
+}
+
+void Grammar::ExecuteSearch(GapBuffer<SymbolID>& string, uint32_t maxSteps, RNG& rng) const {
+    uint32_t depth = 0;
+    std::vector<bool> badRules(_rules.size(), false);
+    size_t badRuleCount = 0;
+
+    while (depth < maxSteps && badRuleCount != _usableRules) {
+        const uint32_t idx = _ruleTable.Sample(rng);
         const RuleInternal& rule = _rules[idx];
-        if (rule.lhs.empty() || badRules.contains(idx)) {
+        if (rule.lhs.empty() || badRules[idx]) {
             continue;
         }
 
-        auto subRange = std::ranges::search(_outputString.begin(), _outputString.end(), rule.lhs.begin(), rule.lhs.end());
-        if (subRange.empty()) {
+        const size_t position = string.Find(rule.lhs);
+        if (position == GapBuffer<SymbolID>::npos) {
             //std::cout << "Sub range is empty" << std::endl;
-            badRules.insert(idx);
+            badRules[idx] = true;
+            ++badRuleCount;
             continue;
         }
 
         // String has been updated, other rules might work again
-        badRules.clear();
-        // inserting symbols from rule
-        _outputString.insert(subRange.begin(), rule.rhs.begin(), rule.rhs.end());
-        // erase old subrange
-        _outputString.erase(subRange.begin(), subRange.end());
+        if (badRuleCount > 0) {
+            std::fill(badRules.begin(), badRules.end(), false);
+            badRuleCount = 0;
+        }
+        // replace the matched symbols with the rule
+        string.Replace(position, rule.lhs.size(), rule.rhs);
+        ++depth;
+    }
+}
+
+void Grammar::ExecuteIndexed(OccurrenceIndex& index, uint32_t maxSteps, RNG& rng) const {
+    // After this many rejected samples fall back to a linear pass over the applicable rules
+    constexpr int MAX_REJECTIONS = 16;
+
+    // The index also holds occurrences of rules with weight 0, there is nothing to sample when no other rule is left
+    if (_usableRules == 0 || _ruleTable.Empty()) {
+        return;
+    }
+
+    uint32_t depth = 0;
+
+    while (depth < maxSteps && !index.ActiveRules().empty()) {
+        uint32_t rule = _ruleTable.Sample(rng);
+
+        for (int i = 0; i < MAX_REJECTIONS && index.OccurrenceCount(rule) == 0; i++) {
+            rule = _ruleTable.Sample(rng);
+        }
+
+        if (index.OccurrenceCount(rule) == 0) {
+            double total = 0.0;
+            for (uint32_t active : index.ActiveRules()) {
+                total += _ruleTable.Weight(active);
+            }
+            if (total <= 0.0) {
+                break; // Only rules with weight 0 apply
+            }
+
+            double pick = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (uint32_t active : index.ActiveRules()) {
+                rule = active;
+                pick -= _ruleTable.Weight(active);
+                if (pick < 0.0 && _ruleTable.Weight(active) > 0.0f) {
+                    break;
+                }
+            }
+        }
+
+        const auto match = index.GetOccurrence(rule, rng() % index.OccurrenceCount(rule));
+        index.Apply(match, _rules[rule].rhs);
         ++depth;
     }
 }
@@ -80,6 +177,30 @@ void Grammar::ConvertRules(const std::vector<Rule> &rules) {
             internal.rhs.emplace_back(_registry.GetSymbol(symbol));
         }
 
+        // A rule with unknown symbols keeps its index but can never be applied
+        const auto isInvalid = [](SymbolID id) { return id == SymbolRegistry::INVALID_SYMBOL; };
+        if (std::ranges::any_of(internal.lhs, isInvalid) || std::ranges::any_of(internal.rhs, isInvalid)) {
+            std::cout << "Rule " << _rules.size() << " uses unknown symbols and is ignored" << std::endl;
+            internal = {};
+        }
+
         _rules.emplace_back(internal);
     }
+
+    std::vector<std::vector<SymbolID>> patterns;
+    patterns.reserve(_rules.size());
+    for (const auto& rule : _rules) {
+        patterns.emplace_back(rule.lhs);
+    }
+    _matcher = RuleMatcher(patterns);
+
+    std::vector<float> weights;
+    weights.reserve(rules.size());
+    _usableRules = 0;
+    for (size_t i = 0; i < rules.size(); i++) {
+        const bool usable = !_rules[i].lhs.empty() && rules[i].weight > 0.0f;
+        weights.emplace_back(usable ? rules[i].weight : 0.0f);
+        _usableRules += usable;
+    }
+    _ruleTable = AliasTable(weights);
 }
@@ -1,8 +1,30 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "alias_table.hpp"
+#include "gap_buffer.hpp"
+#include "rule_matcher.hpp"
 #include "symbol_registry.hpp"
 #include "grammar_rule.hpp"
 
+enum class ExecutionMode {
+    SEARCH, // Picks a random rule and rewrites its leftmost occurrence
+    INDEXED, // Picks a random applicable rule and a random occurrence of it from an incrementally updated index
+};
+
+struct ExecutionSettings {
+    ExecutionMode mode = ExecutionMode::SEARCH;
+    std::optional<uint64_t> seed {}; // Seeded from std::random_device when empty
+    uint32_t maxSteps = 1000; // Maximum number of rewrites
+};
+
+class OccurrenceIndex;
+
 class Grammar {
 public:
     using SymbolID = SymbolRegistry::SymbolID;
@@ -14,10 +36,18 @@ public:
 
     void PrintInfo() const;
 
-    void ExecuteGrammar(const std::list<SymbolID>& startString);
+    void ExecuteGrammar(std::span<const SymbolID> startString, const ExecutionSettings& settings = {});
 
-    const std::list<SymbolID>& GetString() {
-        return _outputString;
+    // Expands every start string on its own seeded stream, derived from seed and the index of the string.
+    // Results do not depend on the number of threads, 0 uses all hardware threads.
+    [[nodiscard]] std::vector<std::vector<SymbolID>> ExecuteBatch(std::span<const std::vector<SymbolID>> startStrings,
+        uint64_t seed, const ExecutionSettings& settings = {}, unsigned threadCount = 0) const;
+
+    // Expands one start string on the stream ExecuteBatch uses for index 0 with this seed, safe to call from several threads
+    [[nodiscard]] std::vector<SymbolID> Expand(std::span<const SymbolID> startString, uint64_t seed, const ExecutionSettings& settings = {}) const;
+
+    std::span<const SymbolID> GetString() {
+        return _outputString.Data();
     }
 
 private:
@@ -28,7 +58,16 @@ private:
 
     void ConvertRules(const std::vector<Rule>& rules);
 
+    using RNG = std::mt19937_64;
+
+    void Execute(std::span<const SymbolID> startString, const ExecutionSettings& settings, RNG& rng, std::vector<SymbolID>& output) const;
+    void ExecuteSearch(GapBuffer<SymbolID>& string, uint32_t maxSteps, RNG& rng) const;
+    void ExecuteIndexed(OccurrenceIndex& index, uint32_t maxSteps, RNG& rng) const;
+
     SymbolRegistry& _registry;
-    std::list<SymbolID> _outputString {};
+    GapBuffer<SymbolID> _outputString {};
     std::vector<RuleInternal> _rules {};
+    RuleMatcher _matcher {};
+    AliasTable _ruleTable {}; // Rule weights, rules with an empty lhs get weight 0
+    size_t _usableRules = 0;
 };
\ No newline at end of file
@@ -7,4 +7,5 @@
 struct Rule {
     std::vector<std::string> lhs;
     std::vector<std::string> rhs;
+    float weight = 1.0f; // Relative probability of picking this rule
 };
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <map>
-#include <unordered_map>
-#include <unordered_set>
+#include <span>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
-using gId = int;
+#include "graph_snapshot.hpp"
+#include "slot_map.hpp"
+
+using gId = SlotId;
 
 using VertexId = gId;
 using EdgeId = gId;
@@ -19,10 +24,16 @@ public:
           _data(data) {
     }
 
+    [[nodiscard]] VertexId Other(const VertexId v) const { return _v1 == v ? _v2 : _v1; }
+
     VertexId _v1;
     VertexId _v2;
 
     T _data;
+
+    // Positions of this edge in the incident lists of _v1 and _v2
+    uint32_t _slot1 = 0;
+    uint32_t _slot2 = 0;
 };
 
 template <typename T>
@@ -33,8 +44,12 @@ public:
     {
     }
 
-    std::vector<EdgeId> _edges;
     T _data;
+
+    // Incident edges, a range of the owning graph's incident pool
+    uint32_t _edgeOffset = 0;
+    uint32_t _edgeCount = 0;
+    uint32_t _edgeCapacity = 0;
 };
 
 
@@ -61,103 +76,303 @@ template <typename vertexType, typename edgeType>
 class Graph
 {
 public:
+    using VertexMap = SlotMap<Vertex<vertexType>>;
+    using EdgeMap = SlotMap<Edge<edgeType>>;
 
     VertexId AddVertex(vertexType vertexData)
     {
-        VertexId curId = _nextVertex;
-        _nextVertex++;
+        return _vertices.Insert(Vertex(vertexData));
+    }
 
-        _vertices.try_emplace(curId, Vertex(vertexData)); // Add to vertices
+    // Ids are returned in the order of the data
+    std::vector<VertexId> AddVertices(std::span<const vertexType> vertexData)
+    {
+        _vertices.Reserve(_vertices.Size() + vertexData.size());
 
-        return curId;
+        std::vector<VertexId> ids;
+        ids.reserve(vertexData.size());
+        for (const auto& data : vertexData) {
+            ids.emplace_back(_vertices.Insert(Vertex(data)));
+        }
+        return ids;
     }
 
     EdgeId AddEdge(VertexId v1, VertexId v2, edgeType edgeData)
     {
-        EdgeId curId = _nextEdge;
-        _nextEdge++;
-
-        _vertices.at(v1)._edges.emplace_back(curId);
-        _vertices.at(v2)._edges.emplace_back(curId);
+        if (!_vertices.Contains(v1) || !_vertices.Contains(v2)) {
+            throw std::out_of_range("Graph::AddEdge with an invalid vertex");
+        }
 
-        _edges.try_emplace(curId, Edge<edgeType>(v1, v2, edgeData));
+        const EdgeId curId = _edges.Insert(Edge<edgeType>(v1, v2, edgeData));
+        _edges.At(curId)._slot1 = Attach(v1, curId);
+        _edges.At(curId)._slot2 = Attach(v2, curId);
 
         return curId;
     }
 
-    void RemoveVertex(const VertexId v)
+    // Edge i connects endpoints[i] with edgeData[i]. Every incident list grows at most once.
+    std::vector<EdgeId> AddEdges(std::span<const std::pair<VertexId, VertexId>> endpoints, std::span<const edgeType> edgeData)
     {
-        if (!_vertices.contains(v)) {
-            std::cout << "tried to remove invalid vertex" << std::endl;
-            return;
+        if (endpoints.size() != edgeData.size()) {
+            throw std::invalid_argument("Graph::AddEdges needs one data element per edge");
         }
 
-        for (size_t i = 0; i < _vertices.at(v)._edges.size(); i++)
-        {
-            EdgeId edgeId = _vertices.at(v)._edges[i];
-
-            auto& edge = _edges.at(edgeId);
+        // Final degrees, counted per dense vertex position
+        std::vector<uint32_t> added(_vertices.Size(), 0);
+        for (const auto& [v1, v2] : endpoints) {
+            if (!_vertices.Contains(v1) || !_vertices.Contains(v2)) {
+                throw std::out_of_range("Graph::AddEdges with an invalid vertex");
+            }
+            ++added[_vertices.DenseIndex(v1)];
+            ++added[_vertices.DenseIndex(v2)];
+        }
 
-            if (edge._v1 == v)
-            {
-                std::erase(_vertices.at(edge._v2)._edges, edgeId);
-            } else {
-                std::erase(_vertices.at(edge._v1)._edges, edgeId);
+        size_t grownCapacity = 0;
+        for (size_t dense = 0; dense < added.size(); dense++) {
+            const auto& vertex = _vertices.Values()[dense];
+            if (vertex._edgeCount + added[dense] > vertex._edgeCapacity) {
+                grownCapacity += vertex._edgeCount + added[dense];
+            }
+        }
+        _incident.reserve(_incident.size() + grownCapacity);
+        for (size_t dense = 0; dense < added.size(); dense++) {
+            auto& vertex = _vertices.Values()[dense];
+            if (vertex._edgeCount + added[dense] > vertex._edgeCapacity) {
+                Relocate(vertex, vertex._edgeCount + added[dense]);
             }
+        }
+
+        _edges.Reserve(_edges.Size() + endpoints.size());
 
-            // Remove edge data
-            _edges.erase(edgeId);
+        std::vector<EdgeId> ids;
+        ids.reserve(endpoints.size());
+        for (size_t i = 0; i < endpoints.size(); i++) {
+            ids.emplace_back(AddEdge(endpoints[i].first, endpoints[i].second, edgeData[i]));
+        }
+        return ids;
+    }
+
+    // O(degree)
+    void RemoveVertex(const VertexId v)
+    {
+        if (!_vertices.Contains(v)) {
+            std::cout << "tried to remove invalid vertex" << std::endl;
+            return;
+        }
+
+        while (_vertices.At(v)._edgeCount > 0) {
+            RemoveEdge(IncidentEdges(v).back());
         }
 
         // Remove vertex
-        _vertices.erase(v);
+        _incidentGarbage += _vertices.At(v)._edgeCapacity;
+        _vertices.Erase(v);
     }
 
+    // O(min(degree v1, degree v2))
     void RemoveEdge(VertexId v1, VertexId v2) {
-        if (!_vertices.contains(v1) || !_vertices.contains(v2)) {
+        if (!_vertices.Contains(v1) || !_vertices.Contains(v2)) {
             std::cout << "tried to remove edge between invalid vertices" << std::endl;
             return;
         }
 
-        // Find edge id
-        const auto& it = std::find_if(_edges.begin(), _edges.end(), [&](std::pair<EdgeId, Edge<edgeType>> pair) {
-            const auto& edge = pair.second;
-            if ((edge._v1 == v1 && edge._v2 == v2) || (edge._v1 == v2 && edge._v2 == v1)) {
-                return true;
-            }
-            return false;
-        });
+        const EdgeId edgeId = FindEdge(v1, v2);
+        if (edgeId.Valid()) {
+            RemoveEdge(edgeId);
+        }
+    }
 
-        if (it == _edges.end()) {
+    // O(1)
+    void RemoveEdge(EdgeId edgeId) {
+        if (!_edges.Contains(edgeId)) {
             return;
         }
 
-        EdgeId edgeId = it->first;
+        // Slots are re-read after each detach, a self loop moves within a single list
+        const auto [v1, v2] = std::pair(_edges.At(edgeId)._v1, _edges.At(edgeId)._v2);
+        Detach(v1, _edges.At(edgeId)._slot1);
+        Detach(v2, _edges.At(edgeId)._slot2);
 
         // Remove edge data
-        _edges.erase(edgeId);
+        _edges.Erase(edgeId);
+    }
+
+    // Edge between the two vertices, an invalid id when there is none. O(min(degree v1, degree v2))
+    [[nodiscard]] EdgeId FindEdge(VertexId v1, VertexId v2) const {
+        if (!_vertices.Contains(v1) || !_vertices.Contains(v2)) {
+            return {};
+        }
+
+        if (Degree(v2) < Degree(v1)) {
+            std::swap(v1, v2);
+        }
+
+        for (const EdgeId edgeId : IncidentEdges(v1)) {
+            if (_edges.At(edgeId).Other(v1) == v2) {
+                return edgeId;
+            }
+        }
+        return {};
+    }
+
+    void Reserve(size_t vertices, size_t edges) {
+        _vertices.Reserve(vertices);
+        _edges.Reserve(edges);
+        _incident.reserve(edges * 2);
+    }
+
+    // Lays the incident lists out back to back in vertex order without spare capacity, like a CSR adjacency.
+    // Call after building a graph, before running passes that walk the adjacency.
+    void Finalize() {
+        std::vector<EdgeId> incident;
+        incident.reserve(_edges.Size() * 2);
+
+        for (auto& vertex : _vertices.Values()) {
+            const auto offset = static_cast<uint32_t>(incident.size());
+            incident.insert(incident.end(), _incident.begin() + vertex._edgeOffset, _incident.begin() + vertex._edgeOffset + vertex._edgeCount);
+            vertex._edgeOffset = offset;
+            vertex._edgeCapacity = vertex._edgeCount;
+        }
+
+        _incident = std::move(incident);
+        _incidentGarbage = 0;
+    }
+
+    // Dense CSR copy for read-only passes, see graph_algorithms.hpp. Edge weights are 1.
+    [[nodiscard]] GraphSnapshot Snapshot() const {
+        return Snapshot([](const edgeType&) { return 1.0f; });
+    }
+
+    // weight(const edgeType&) gives the weight of every edge
+    template <typename WeightFn>
+    [[nodiscard]] GraphSnapshot Snapshot(WeightFn weight) const {
+        using Index = GraphSnapshot::Index;
+
+        std::vector<Index> offsets;
+        offsets.reserve(_vertices.Size() + 1);
+        offsets.emplace_back(0);
+        for (const auto& vertex : _vertices.Values()) {
+            offsets.emplace_back(offsets.back() + vertex._edgeCount);
+        }
+
+        std::vector<Index> neighbours(offsets.back());
+        std::vector<Index> incidentEdges(offsets.back());
+        for (Index v = 0; v < _vertices.Size(); v++) {
+            const auto& vertex = _vertices.Values()[v];
+            const VertexId id = _vertices.IdAt(v);
+            for (uint32_t i = 0; i < vertex._edgeCount; i++) {
+                const EdgeId edgeId = _incident[vertex._edgeOffset + i];
+                neighbours[offsets[v] + i] = static_cast<Index>(_vertices.DenseIndex(_edges.At(edgeId).Other(id)));
+                incidentEdges[offsets[v] + i] = static_cast<Index>(_edges.DenseIndex(edgeId));
+            }
+        }
+
+        std::vector<GraphSnapshot::Edge> edges;
+        std::vector<float> weights;
+        std::vector<SlotId> edgeIds;
+        edges.reserve(_edges.Size());
+        weights.reserve(_edges.Size());
+        edgeIds.reserve(_edges.Size());
+        for (Index e = 0; e < _edges.Size(); e++) {
+            const auto& edge = _edges.Values()[e];
+            edges.push_back({static_cast<Index>(_vertices.DenseIndex(edge._v1)), static_cast<Index>(_vertices.DenseIndex(edge._v2))});
+            weights.emplace_back(static_cast<float>(weight(edge._data)));
+            edgeIds.emplace_back(_edges.IdAt(e));
+        }
+
+        std::vector<SlotId> vertexIds;
+        vertexIds.reserve(_vertices.Size());
+        for (Index v = 0; v < _vertices.Size(); v++) {
+            vertexIds.emplace_back(_vertices.IdAt(v));
+        }
+
+        return {std::move(offsets), std::move(neighbours), std::move(incidentEdges), std::move(edges), std::move(weights),
+            std::move(vertexIds), std::move(edgeIds)};
+    }
 
-        // Remove edge from vertices
-        std::erase(_vertices.at(v1)._edges, edgeId);
-        std::erase(_vertices.at(v2)._edges, edgeId);
+    // Invalidated by adding or removing edges
+    [[nodiscard]] std::span<const EdgeId> IncidentEdges(VertexId v) const {
+        const auto& vertex = _vertices.At(v);
+        return std::span<const EdgeId>(_incident).subspan(vertex._edgeOffset, vertex._edgeCount);
     }
 
-    const std::unordered_map<VertexId, Vertex<vertexType>>& VertexData()
+    [[nodiscard]] size_t Degree(VertexId v) const { return _vertices.At(v)._edgeCount; }
+
+    [[nodiscard]] bool Contains(VertexId v) const { return _vertices.Contains(v); }
+    [[nodiscard]] size_t VertexCount() const { return _vertices.Size(); }
+    [[nodiscard]] size_t EdgeCount() const { return _edges.Size(); }
+
+    [[nodiscard]] const Vertex<vertexType>& GetVertex(VertexId v) const { return _vertices.At(v); }
+    [[nodiscard]] const Edge<edgeType>& GetEdge(EdgeId e) const { return _edges.At(e); }
+    vertexType& VertexValue(VertexId v) { return _vertices.At(v)._data; }
+    edgeType& EdgeValue(EdgeId e) { return _edges.At(e)._data; }
+
+    const VertexMap& VertexData() const
     {
         return _vertices;
     }
 
-    const std::unordered_map<EdgeId, Edge<edgeType>>& EdgeData()
+    const EdgeMap& EdgeData() const
     {
         return _edges;
     }
 
 private:
+    // Appends to the incident list of v and returns the position
+    uint32_t Attach(VertexId v, EdgeId edgeId) {
+        auto& vertex = _vertices.At(v);
+        if (vertex._edgeCount == vertex._edgeCapacity) {
+            Relocate(vertex, std::max<uint32_t>(4, vertex._edgeCapacity * 2));
+        }
 
-    std::unordered_map<VertexId, Vertex<vertexType>> _vertices;
-    std::unordered_map<EdgeId, Edge<edgeType>> _edges;
+        _incident[vertex._edgeOffset + vertex._edgeCount] = edgeId;
+        return vertex._edgeCount++;
+    }
 
-    VertexId _nextVertex = 0;
-    EdgeId _nextEdge = 0;
-};
+    // Swap and pop the edge at slot out of the incident list of v, fixing the slot of the edge that moved
+    void Detach(VertexId v, uint32_t slot) {
+        auto& vertex = _vertices.At(v);
+        const uint32_t last = vertex._edgeCount - 1;
+        const EdgeId moved = _incident[vertex._edgeOffset + last];
+        _incident[vertex._edgeOffset + slot] = moved;
+        --vertex._edgeCount;
+
+        if (slot != last) {
+            auto& movedEdge = _edges.At(moved);
+            if (movedEdge._v1 == v && movedEdge._slot1 == last) {
+                movedEdge._slot1 = slot;
+            } else {
+                movedEdge._slot2 = slot;
+            }
+        }
+    }
 
+    // Moves the incident list of a vertex to the end of the pool with room for capacity edges
+    void Relocate(Vertex<vertexType>& vertex, uint32_t capacity) {
+        // The list at the end of the pool grows in place
+        if (vertex._edgeOffset + vertex._edgeCapacity == _incident.size()) {
+            _incident.resize(vertex._edgeOffset + capacity);
+            vertex._edgeCapacity = capacity;
+            return;
+        }
+
+        // Reclaim abandoned ranges once they outweigh the live ones
+        if (_incidentGarbage > _incident.size() / 2 && _incidentGarbage > 1024) {
+            Finalize();
+        }
+
+        const auto offset = static_cast<uint32_t>(_incident.size());
+        _incident.resize(_incident.size() + capacity);
+        std::copy_n(_incident.begin() + vertex._edgeOffset, vertex._edgeCount, _incident.begin() + offset);
+
+        _incidentGarbage += vertex._edgeCapacity;
+        vertex._edgeOffset = offset;
+        vertex._edgeCapacity = capacity;
+    }
+
+    VertexMap _vertices;
+    EdgeMap _edges;
+
+    std::vector<EdgeId> _incident {}; // Incident lists of all vertices
+    size_t _incidentGarbage = 0; // Pool entries no list uses anymore
+};
@@ -0,0 +1,233 @@
+#include "graph_algorithms.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+
+namespace GraphAlgorithms {
+
+BreadthFirstResult BreadthFirst(const GraphSnapshot& graph, Index source) {
+    BreadthFirstResult result;
+    result.hops.assign(graph.VertexCount(), UNREACHABLE);
+    result.parent.assign(graph.VertexCount(), GraphSnapshot::INVALID_INDEX);
+    result.order.reserve(graph.VertexCount());
+
+    // The visiting order doubles as the queue
+    result.hops[source] = 0;
+    result.order.emplace_back(source);
+    for (size_t head = 0; head < result.order.size(); head++) {
+        const Index v = result.order[head];
+        for (Index neighbour : graph.Neighbours(v)) {
+            if (result.hops[neighbour] == UNREACHABLE) {
+                result.hops[neighbour] = result.hops[v] + 1;
+                result.parent[neighbour] = v;
+                result.order.emplace_back(neighbour);
+            }
+        }
+    }
+
+    return result;
+}
+
+ShortestPaths Dijkstra(const GraphSnapshot& graph, Index source) {
+    ShortestPaths result;
+    result.distance.assign(graph.VertexCount(), INFINITE_DISTANCE);
+    result.parent.assign(graph.VertexCount(), GraphSnapshot::INVALID_INDEX);
+
+    using QueueEntry = std::pair<float, Index>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+
+    result.distance[source] = 0.0f;
+    queue.emplace(0.0f, source);
+
+    while (!queue.empty()) {
+        const auto [distance, v] = queue.top();
+        queue.pop();
+
+        // Entries are not updated in place, skip the outdated ones
+        if (distance > result.distance[v]) {
+            continue;
+        }
+
+        const auto neighbours = graph.Neighbours(v);
+        const auto edges = graph.IncidentEdges(v);
+        for (size_t i = 0; i < neighbours.size(); i++) {
+            const float next = distance + graph.Weight(edges[i]);
+            if (next < result.distance[neighbours[i]]) {
+                result.distance[neighbours[i]] = next;
+                result.parent[neighbours[i]] = v;
+                queue.emplace(next, neighbours[i]);
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<Index> ExtractPath(const std::vector<Index>& parent, Index source, Index target) {
+    std::vector<Index> path;
+    if (target >= parent.size()) {
+        return path;
+    }
+
+    for (Index v = target; v != GraphSnapshot::INVALID_INDEX; v = parent[v]) {
+        path.emplace_back(v);
+    }
+    // Unreached vertices have no parent either, their walk ends somewhere other than the source
+    if (path.back() != source) {
+        return {};
+    }
+    std::ranges::reverse(path);
+    return path;
+}
+
+Components ConnectedComponents(const GraphSnapshot& graph) {
+    Components result;
+    result.component.assign(graph.VertexCount(), GraphSnapshot::INVALID_INDEX);
+
+    std::vector<Index> stack;
+    for (Index root = 0; root < graph.VertexCount(); root++) {
+        if (result.component[root] != GraphSnapshot::INVALID_INDEX) {
+            continue;
+        }
+
+        result.component[root] = result.count;
+        stack.emplace_back(root);
+        while (!stack.empty()) {
+            const Index v = stack.back();
+            stack.pop_back();
+            for (Index neighbour : graph.Neighbours(v)) {
+                if (result.component[neighbour] == GraphSnapshot::INVALID_INDEX) {
+                    result.component[neighbour] = result.count;
+                    stack.emplace_back(neighbour);
+                }
+            }
+        }
+        ++result.count;
+    }
+
+    return result;
+}
+
+Cuts BridgesAndArticulationPoints(const GraphSnapshot& graph) {
+    const size_t vertexCount = graph.VertexCount();
+
+    // Tarjan's lowpoint search with an explicit stack, dungeons are deep enough to overflow the call stack
+    struct Frame {
+        Index vertex;
+        Index parentEdge;
+        uint32_t next; // Next position in the adjacency of vertex
+    };
+
+    std::vector<uint32_t> discovery(vertexCount, UNREACHABLE);
+    std::vector<uint32_t> low(vertexCount, 0);
+    std::vector<bool> isArticulation(vertexCount, false);
+    std::vector<Frame> stack;
+    uint32_t time = 0;
+
+    Cuts result;
+
+    for (Index root = 0; root < vertexCount; root++) {
+        if (discovery[root] != UNREACHABLE) {
+            continue;
+        }
+
+        uint32_t rootChildren = 0;
+        discovery[root] = low[root] = time++;
+        stack.push_back({root, GraphSnapshot::INVALID_INDEX, 0});
+
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            const auto neighbours = graph.Neighbours(frame.vertex);
+            const auto edges = graph.IncidentEdges(frame.vertex);
+
+            if (frame.next < neighbours.size()) {
+                const Index neighbour = neighbours[frame.next];
+                const Index edge = edges[frame.next];
+                ++frame.next;
+
+                // Parallel edges are separate, only the edge that was walked down is skipped
+                if (edge == frame.parentEdge) {
+                    continue;
+                }
+
+                if (discovery[neighbour] == UNREACHABLE) {
+                    discovery[neighbour] = low[neighbour] = time++;
+                    rootChildren += frame.vertex == root;
+                    stack.push_back({neighbour, edge, 0});
+                } else {
+                    low[frame.vertex] = std::min(low[frame.vertex], discovery[neighbour]);
+                }
+                continue;
+            }
+
+            // All children done, hand the lowpoint to the parent
+            const Frame done = frame;
+            stack.pop_back();
+            if (stack.empty()) {
+                continue;
+            }
+
+            const Index parent = stack.back().vertex;
+            low[parent] = std::min(low[parent], low[done.vertex]);
+            if (low[done.vertex] > discovery[parent]) {
+                result.bridges.emplace_back(done.parentEdge);
+            }
+            if (parent != root && low[done.vertex] >= discovery[parent]) {
+                isArticulation[parent] = true;
+            }
+        }
+
+        if (rootChildren > 1) {
+            isArticulation[root] = true;
+        }
+    }
+
+    for (Index v = 0; v < vertexCount; v++) {
+        if (isArticulation[v]) {
+            result.articulationPoints.emplace_back(v);
+        }
+    }
+
+    return result;
+}
+
+std::vector<Index> MinimumSpanningForest(const GraphSnapshot& graph) {
+    std::vector<Index> order(graph.EdgeCount());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::sort(order, [&](Index a, Index b) { return graph.Weight(a) < graph.Weight(b); });
+
+    // Union find with path halving and union by size
+    std::vector<Index> parent(graph.VertexCount());
+    std::vector<uint32_t> size(graph.VertexCount(), 1);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    const auto& find = [&](Index v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+
+    std::vector<Index> forest;
+    forest.reserve(graph.VertexCount());
+    for (Index e : order) {
+        Index a = find(graph.GetEdge(e).source);
+        Index b = find(graph.GetEdge(e).target);
+        if (a == b) {
+            continue;
+        }
+
+        if (size[a] < size[b]) {
+            std::swap(a, b);
+        }
+        parent[b] = a;
+        size[a] += size[b];
+        forest.emplace_back(e);
+    }
+
+    return forest;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "graph_snapshot.hpp"
+
+// Kernels over a GraphSnapshot. They only read the snapshot, so several can run on one snapshot at once.
+namespace GraphAlgorithms {
+
+using Index = GraphSnapshot::Index;
+
+constexpr uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max();
+constexpr float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+struct BreadthFirstResult {
+    std::vector<uint32_t> hops {}; // UNREACHABLE for vertices that cannot be reached
+    std::vector<Index> parent {}; // INVALID_INDEX for the source and unreachable vertices
+    std::vector<Index> order {}; // Reached vertices in visiting order
+};
+
+struct ShortestPaths {
+    std::vector<float> distance {}; // INFINITE_DISTANCE for vertices that cannot be reached
+    std::vector<Index> parent {};
+};
+
+struct Components {
+    std::vector<Index> component {}; // Component of every vertex, numbered from 0
+    uint32_t count = 0;
+};
+
+struct Cuts {
+    std::vector<Index> bridges {}; // Edges whose removal disconnects their component
+    std::vector<Index> articulationPoints {}; // Vertices whose removal disconnects their component
+};
+
+[[nodiscard]] BreadthFirstResult BreadthFirst(const GraphSnapshot& graph, Index source);
+
+// Edge weights have to be non-negative
+[[nodiscard]] ShortestPaths Dijkstra(const GraphSnapshot& graph, Index source);
+
+// Vertices from source to target along the parent tree of a search from source, empty when target was not reached
+[[nodiscard]] std::vector<Index> ExtractPath(const std::vector<Index>& parent, Index source, Index target);
+
+[[nodiscard]] Components ConnectedComponents(const GraphSnapshot& graph);
+
+[[nodiscard]] Cuts BridgesAndArticulationPoints(const GraphSnapshot& graph);
+
+// Edges of a minimum spanning tree of every component, Kruskal on the snapshot weights
+[[nodiscard]] std::vector<Index> MinimumSpanningForest(const GraphSnapshot& graph);
+
+}
@@ -0,0 +1,492 @@
+#include "graph_rewriter.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+
+GraphRewriter::GraphRewriter(SymbolRegistry& registry, const std::vector<GraphRule>& rules)
+    : _registry(registry) {
+    ConvertRules(rules);
+}
+
+void GraphRewriter::PrintInfo() const {
+    std::cout << "---------- \nGraph Grammar Info" << std::endl;
+
+    const auto& printNodes = [&](const std::vector<SymbolID>& nodes) {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            std::cout << i << ":" << _registry.GetSymbolData(nodes[i])->name << " ";
+        }
+        std::endl(std::cout);
+    };
+    const auto& printEdges = [&](const std::vector<PatternEdge>& edges) {
+        for (const auto& edge : edges) {
+            std::cout << edge.from << "-" << edge.to;
+            if (edge.label != SymbolRegistry::INVALID_SYMBOL) {
+                std::cout << "(" << _registry.GetSymbolData(edge.label)->name << ")";
+            }
+            std::cout << " ";
+        }
+        std::endl(std::cout);
+    };
+
+    int ruleCounter = 0;
+    for (const auto& rule : _rules) {
+        std::cout << "Rule " << ruleCounter << std::endl;
+        std::cout << "  lhs nodes: ";
+        printNodes(rule.lhsNodes);
+        std::cout << "  lhs edges: ";
+        printEdges(rule.lhsEdges);
+        std::cout << "  rhs nodes: ";
+        printNodes(rule.rhsNodes);
+        std::cout << "  rhs edges: ";
+        printEdges(rule.rhsEdges);
+        ruleCounter++;
+    }
+}
+
+void GraphRewriter::SetGraph(LabelGraph graph) {
+    _graph = std::move(graph);
+
+    _vertexInfo.clear();
+    _labelVertices.clear();
+    _matches.Clear();
+    for (auto& matches : _ruleMatches) {
+        matches.clear();
+    }
+    _activeRules.clear();
+    std::ranges::fill(_activePosition, NONE);
+
+    for (const auto& vertex : _graph.VertexData()) {
+        IndexVertex(vertex.first);
+    }
+
+    // Every match once, rooted at the lhs node whose label has the fewest vertices
+    for (uint32_t r = 0; r < _rules.size(); r++) {
+        const RuleInternal& rule = _rules[r];
+        if (rule.lhsNodes.empty() || _ruleTable.Weight(r) <= 0.0f) {
+            continue;
+        }
+
+        const auto& candidateCount = [&](uint32_t node) {
+            const SymbolID label = rule.lhsNodes[node];
+            return label < _labelVertices.size() ? _labelVertices[label].size() : 0;
+        };
+
+        uint32_t root = 0;
+        for (uint32_t node = 1; node < rule.lhsNodes.size(); node++) {
+            if (candidateCount(node) < candidateCount(root)) {
+                root = node;
+            }
+        }
+
+        if (candidateCount(root) == 0) {
+            continue;
+        }
+
+        for (VertexId vertex : _labelVertices[rule.lhsNodes[root]]) {
+            Search(r, root, vertex, false);
+        }
+    }
+}
+
+uint32_t GraphRewriter::Execute(const ExecutionSettings& settings) {
+    // After this many rejected samples fall back to a linear pass over the applicable rules
+    constexpr int MAX_REJECTIONS = 16;
+
+    RNG rng(settings.seed.has_value() ? *settings.seed : std::random_device{}());
+    uint32_t depth = 0;
+
+    while (depth < settings.maxSteps && !_activeRules.empty()) {
+        uint32_t rule = _ruleTable.Sample(rng);
+
+        for (int i = 0; i < MAX_REJECTIONS && _ruleMatches[rule].empty(); i++) {
+            rule = _ruleTable.Sample(rng);
+        }
+
+        if (_ruleMatches[rule].empty()) {
+            double total = 0.0;
+            for (uint32_t active : _activeRules) {
+                total += _ruleTable.Weight(active);
+            }
+
+            double pick = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (uint32_t active : _activeRules) {
+                rule = active;
+                pick -= _ruleTable.Weight(active);
+                if (pick < 0.0) {
+                    break;
+                }
+            }
+        }
+
+        Apply(_ruleMatches[rule][rng() % _ruleMatches[rule].size()]);
+        ++depth;
+    }
+
+    return depth;
+}
+
+void GraphRewriter::Apply(MatchId matchId) {
+    const uint32_t r = _matches.At(matchId).rule;
+    const RuleInternal& rule = _rules[r];
+    _binding = _matches.At(matchId).vertices;
+
+    ++_stamp;
+
+    // Every match that uses a matched vertex can change, this includes the applied match
+    for (VertexId vertex : _binding) {
+        RemoveMatchesAt(vertex);
+    }
+
+    for (const auto& edge : rule.lhsEdges) {
+        const EdgeId edgeId = FindEdge(_binding[edge.from], _binding[edge.to], edge.label);
+        if (edgeId.Valid()) {
+            _graph.RemoveEdge(edgeId); // Parallel lhs edges can share one host edge
+        }
+    }
+
+    for (uint32_t node = 0; node < rule.lhsNodes.size(); node++) {
+        if (rule.keptAs[node] == NONE) {
+            UnindexVertex(_binding[node]);
+            _graph.RemoveVertex(_binding[node]);
+        }
+    }
+
+    _rewriteVertices.clear();
+    for (uint32_t node = 0; node < rule.rhsNodes.size(); node++) {
+        VertexId vertex;
+        if (rule.keptFrom[node] != NONE) {
+            vertex = _binding[rule.keptFrom[node]];
+            if (Label(vertex) != rule.rhsNodes[node]) {
+                UnindexVertex(vertex);
+                _graph.VertexValue(vertex) = rule.rhsNodes[node];
+                IndexVertex(vertex);
+            }
+        } else {
+            vertex = _graph.AddVertex(rule.rhsNodes[node]);
+            IndexVertex(vertex);
+        }
+
+        Info(vertex).stamp = _stamp;
+        _rewriteVertices.emplace_back(vertex);
+    }
+
+    for (const auto& edge : rule.rhsEdges) {
+        _graph.AddEdge(_rewriteVertices[edge.from], _rewriteVertices[edge.to], edge.label);
+    }
+
+    // Removing vertices and edges cannot create matches, new ones contain a vertex of the rhs
+    for (VertexId vertex : _rewriteVertices) {
+        const SymbolID label = Label(vertex);
+        if (label >= _labelRoots.size()) {
+            continue;
+        }
+        for (const auto& [rootRule, root] : _labelRoots[label]) {
+            Search(rootRule, root, vertex, true);
+        }
+    }
+}
+
+void GraphRewriter::Search(uint32_t rule, uint32_t root, VertexId start, bool onlyNew) {
+    const RuleInternal& internal = _rules[rule];
+    const SearchPlan& plan = internal.plans[root];
+
+    _binding.assign(internal.lhsNodes.size(), VertexId{});
+    if (Label(start) != internal.lhsNodes[root] || !CanBind(internal, plan, 0, start, root, onlyNew)) {
+        return;
+    }
+
+    _binding[root] = start;
+    Extend(rule, root, 1, onlyNew);
+}
+
+void GraphRewriter::Extend(uint32_t rule, uint32_t root, size_t depth, bool onlyNew) {
+    const RuleInternal& internal = _rules[rule];
+    const SearchPlan& plan = internal.plans[root];
+
+    if (depth == plan.order.size()) {
+        AddMatch(rule);
+        return;
+    }
+
+    const uint32_t node = plan.order[depth];
+    const PatternEdge& parent = internal.lhsEdges[plan.parentEdge[depth]];
+    const VertexId from = _binding[parent.from == node ? parent.to : parent.from];
+
+    // Parallel host edges lead to the same neighbour more than once
+    auto& candidates = _candidates[depth];
+    candidates.clear();
+    for (EdgeId edgeId : _graph.IncidentEdges(from)) {
+        const auto& edge = _graph.GetEdge(edgeId);
+        const VertexId other = edge.Other(from);
+        if ((parent.label == SymbolRegistry::INVALID_SYMBOL || edge._data == parent.label) && Label(other) == internal.lhsNodes[node]) {
+            candidates.emplace_back(other);
+        }
+    }
+    std::ranges::sort(candidates, {}, &VertexId::index);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (VertexId candidate : candidates) {
+        if (CanBind(internal, plan, depth, candidate, root, onlyNew)) {
+            _binding[node] = candidate;
+            Extend(rule, root, depth + 1, onlyNew);
+        }
+    }
+    _binding[node] = {};
+}
+
+bool GraphRewriter::CanBind(const RuleInternal& rule, const SearchPlan& plan, size_t depth, VertexId vertex, uint32_t root, bool onlyNew) const {
+    const uint32_t node = plan.order[depth];
+
+    if (onlyNew && node < root && _vertexInfo[vertex.index].stamp == _stamp) {
+        return false;
+    }
+
+    for (size_t i = 0; i < depth; i++) {
+        if (_binding[plan.order[i]] == vertex) {
+            return false;
+        }
+    }
+
+    for (uint32_t e : plan.checks[depth]) {
+        const PatternEdge& edge = rule.lhsEdges[e];
+        const VertexId other = edge.from == node ? _binding[edge.to] : _binding[edge.from];
+        if (!FindEdge(vertex, edge.from == edge.to ? vertex : other, edge.label).Valid()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GraphRewriter::AddMatch(uint32_t rule) {
+    auto& ruleMatches = _ruleMatches[rule];
+    const MatchId id = _matches.Insert(Match{rule, static_cast<uint32_t>(ruleMatches.size()), _binding});
+    ruleMatches.emplace_back(id);
+
+    if (_activePosition[rule] == NONE) {
+        _activePosition[rule] = static_cast<uint32_t>(_activeRules.size());
+        _activeRules.emplace_back(rule);
+    }
+
+    for (VertexId vertex : _binding) {
+        auto& matches = _vertexInfo[vertex.index].matches;
+        // Drop matches that were removed through other vertices before the list doubles
+        if (matches.size() >= 8 && (matches.size() & (matches.size() - 1)) == 0) {
+            std::erase_if(matches, [&](MatchId match) { return !_matches.Contains(match); });
+        }
+        matches.emplace_back(id);
+    }
+}
+
+void GraphRewriter::RemoveMatch(MatchId matchId) {
+    const Match& match = _matches.At(matchId);
+    const uint32_t rule = match.rule;
+    auto& ruleMatches = _ruleMatches[rule];
+
+    const MatchId moved = ruleMatches.back();
+    ruleMatches[match.slot] = moved;
+    _matches.At(moved).slot = match.slot;
+    ruleMatches.pop_back();
+
+    if (ruleMatches.empty()) {
+        const uint32_t position = _activePosition[rule];
+        _activeRules[position] = _activeRules.back();
+        _activePosition[_activeRules[position]] = position;
+        _activeRules.pop_back();
+        _activePosition[rule] = NONE;
+    }
+
+    _matches.Erase(matchId);
+}
+
+void GraphRewriter::RemoveMatchesAt(VertexId vertex) {
+    auto& matches = _vertexInfo[vertex.index].matches;
+    for (MatchId match : matches) {
+        if (_matches.Contains(match)) {
+            RemoveMatch(match);
+        }
+    }
+    matches.clear();
+}
+
+EdgeId GraphRewriter::FindEdge(VertexId v1, VertexId v2, SymbolID label) const {
+    if (_graph.Degree(v2) < _graph.Degree(v1)) {
+        std::swap(v1, v2);
+    }
+
+    for (EdgeId edgeId : _graph.IncidentEdges(v1)) {
+        const auto& edge = _graph.GetEdge(edgeId);
+        if (edge.Other(v1) == v2 && (label == SymbolRegistry::INVALID_SYMBOL || edge._data == label)) {
+            return edgeId;
+        }
+    }
+    return {};
+}
+
+GraphRewriter::VertexInfo& GraphRewriter::Info(VertexId vertex) {
+    if (vertex.index >= _vertexInfo.size()) {
+        _vertexInfo.resize(vertex.index + 1);
+    }
+    return _vertexInfo[vertex.index];
+}
+
+void GraphRewriter::IndexVertex(VertexId vertex) {
+    VertexInfo& info = Info(vertex);
+    info.matches.clear(); // The slot can belong to a removed vertex
+    info.stamp = 0;
+
+    const SymbolID label = Label(vertex);
+    if (label == SymbolRegistry::INVALID_SYMBOL) {
+        info.labelSlot = NONE;
+        return;
+    }
+    if (label >= _labelVertices.size()) {
+        _labelVertices.resize(label + 1);
+    }
+
+    info.labelSlot = static_cast<uint32_t>(_labelVertices[label].size());
+    _labelVertices[label].emplace_back(vertex);
+}
+
+void GraphRewriter::UnindexVertex(VertexId vertex) {
+    VertexInfo& info = _vertexInfo[vertex.index];
+    if (info.labelSlot == NONE) {
+        return;
+    }
+
+    auto& vertices = _labelVertices[Label(vertex)];
+    const VertexId moved = vertices.back();
+    vertices[info.labelSlot] = moved;
+    _vertexInfo[moved.index].labelSlot = info.labelSlot;
+    vertices.pop_back();
+    info.labelSlot = NONE;
+}
+
+GraphRewriter::SearchPlan GraphRewriter::BuildPlan(const RuleInternal& rule, uint32_t root) {
+    const size_t nodeCount = rule.lhsNodes.size();
+    SearchPlan plan;
+    std::vector<uint32_t> position(nodeCount, NONE);
+
+    // Breadth first over the lhs, every node after the root is reached through an edge to an earlier node
+    std::queue<uint32_t> queue;
+    queue.push(root);
+    position[root] = 0;
+    plan.order.emplace_back(root);
+    plan.parentEdge.emplace_back(NONE);
+
+    while (!queue.empty()) {
+        const uint32_t node = queue.front();
+        queue.pop();
+
+        for (uint32_t e = 0; e < rule.lhsEdges.size(); e++) {
+            const PatternEdge& edge = rule.lhsEdges[e];
+            if (edge.from != node && edge.to != node) {
+                continue;
+            }
+            const uint32_t other = edge.from == node ? edge.to : edge.from;
+            if (position[other] == NONE) {
+                position[other] = static_cast<uint32_t>(plan.order.size());
+                plan.order.emplace_back(other);
+                plan.parentEdge.emplace_back(e);
+                queue.push(other);
+            }
+        }
+    }
+
+    // Disconnected lhs, the caller rejects the rule
+    if (plan.order.size() != nodeCount) {
+        return {};
+    }
+
+    plan.checks.resize(nodeCount);
+    for (uint32_t e = 0; e < rule.lhsEdges.size(); e++) {
+        const PatternEdge& edge = rule.lhsEdges[e];
+        const uint32_t later = std::max(position[edge.from], position[edge.to]);
+        if (plan.parentEdge[later] != e) {
+            plan.checks[later].emplace_back(e);
+        }
+    }
+
+    return plan;
+}
+
+void GraphRewriter::ConvertRules(const std::vector<GraphRule>& rules) {
+    size_t maxNodes = 0;
+
+    for (const auto& rule : rules) {
+        RuleInternal internal;
+        bool valid = !rule.lhsNodes.empty();
+
+        const auto& convertNodes = [&](const std::vector<std::string>& nodes, std::vector<SymbolID>& out) {
+            for (const auto& name : nodes) {
+                out.emplace_back(_registry.GetSymbol(name));
+                valid &= out.back() != SymbolRegistry::INVALID_SYMBOL;
+            }
+        };
+        const auto& convertEdges = [&](const std::vector<GraphRule::Edge>& edges, size_t nodeCount, std::vector<PatternEdge>& out) {
+            for (const auto& edge : edges) {
+                const SymbolID label = edge.label.empty() ? SymbolRegistry::INVALID_SYMBOL : _registry.GetSymbol(edge.label);
+                valid &= edge.from < nodeCount && edge.to < nodeCount;
+                valid &= edge.label.empty() || label != SymbolRegistry::INVALID_SYMBOL;
+                out.emplace_back(PatternEdge{edge.from, edge.to, label});
+            }
+        };
+
+        convertNodes(rule.lhsNodes, internal.lhsNodes);
+        convertNodes(rule.rhsNodes, internal.rhsNodes);
+        convertEdges(rule.lhsEdges, rule.lhsNodes.size(), internal.lhsEdges);
+        convertEdges(rule.rhsEdges, rule.rhsNodes.size(), internal.rhsEdges);
+
+        internal.keptAs.assign(internal.lhsNodes.size(), NONE);
+        internal.keptFrom.assign(internal.rhsNodes.size(), NONE);
+        for (const auto& [lhs, rhs] : rule.kept) {
+            if (lhs >= internal.lhsNodes.size() || rhs >= internal.rhsNodes.size()
+                || internal.keptAs[lhs] != NONE || internal.keptFrom[rhs] != NONE) {
+                valid = false;
+                break;
+            }
+            internal.keptAs[lhs] = rhs;
+            internal.keptFrom[rhs] = lhs;
+        }
+
+        if (valid) {
+            for (uint32_t root = 0; root < internal.lhsNodes.size(); root++) {
+                internal.plans.emplace_back(BuildPlan(internal, root));
+            }
+            valid = !internal.plans.front().order.empty();
+        }
+
+        // An invalid rule keeps its index but can never be applied
+        if (!valid) {
+            std::cout << "Graph rule " << _rules.size() << " is disconnected, malformed or uses unknown symbols and is ignored" << std::endl;
+            internal = {};
+        }
+
+        maxNodes = std::max(maxNodes, internal.lhsNodes.size());
+        _rules.emplace_back(std::move(internal));
+    }
+
+    std::vector<float> weights;
+    weights.reserve(rules.size());
+    for (uint32_t r = 0; r < rules.size(); r++) {
+        const bool usable = !_rules[r].lhsNodes.empty() && rules[r].weight > 0.0f;
+        weights.emplace_back(usable ? rules[r].weight : 0.0f);
+
+        if (!usable) {
+            continue;
+        }
+        for (uint32_t node = 0; node < _rules[r].lhsNodes.size(); node++) {
+            const SymbolID label = _rules[r].lhsNodes[node];
+            if (label >= _labelRoots.size()) {
+                _labelRoots.resize(label + 1);
+            }
+            _labelRoots[label].emplace_back(r, node);
+        }
+    }
+    _ruleTable = AliasTable(weights);
+
+    _ruleMatches.resize(_rules.size());
+    _activePosition.assign(_rules.size(), NONE);
+    _candidates.resize(maxNodes);
+}
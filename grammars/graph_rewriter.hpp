@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "alias_table.hpp"
+#include "grammar.hpp"
+#include "graph.hpp"
+#include "graph_rule.hpp"
+#include "slot_map.hpp"
+#include "symbol_registry.hpp"
+
+// Rewrites a labeled graph with GraphRules.
+// Vertices are indexed by label and every match of every rule is kept up to date. A rewrite only searches
+// for new matches that contain one of the vertices it created or relabeled, so the cost of a step depends
+// on the size of the rules and the local degree, not on the size of the graph.
+// Matches are mappings of lhs nodes to vertices, a symmetric lhs matches the same vertices more than once.
+class GraphRewriter {
+public:
+    using SymbolID = SymbolRegistry::SymbolID;
+    using LabelGraph = Graph<SymbolID, SymbolID>; // Vertex and edge data are labels
+
+    GraphRewriter(SymbolRegistry& registry, const std::vector<GraphRule>& rules);
+
+    void PrintInfo() const;
+
+    // Takes the graph to rewrite and finds every match in it
+    void SetGraph(LabelGraph graph);
+    [[nodiscard]] const LabelGraph& GetGraph() const { return _graph; }
+
+    // Applies up to settings.maxSteps random rewrites and returns how many were applied, settings.mode is unused
+    uint32_t Execute(const ExecutionSettings& settings = {});
+
+    [[nodiscard]] size_t MatchCount() const { return _matches.Size(); }
+    [[nodiscard]] size_t MatchCount(uint32_t rule) const { return _ruleMatches[rule].size(); }
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    using RNG = std::mt19937_64;
+    using MatchId = SlotId;
+
+    struct PatternEdge {
+        uint32_t from;
+        uint32_t to;
+        SymbolID label; // INVALID_SYMBOL matches any edge
+    };
+
+    // Order in which the lhs nodes get bound when a search starts at one of them
+    struct SearchPlan {
+        std::vector<uint32_t> order {}; // order[0] is the root
+        std::vector<uint32_t> parentEdge {}; // Lhs edge that leads to order[i] from an earlier node, unused for the root
+        std::vector<std::vector<uint32_t>> checks {}; // Other lhs edges between order[i] and earlier nodes or itself
+    };
+
+    struct RuleInternal {
+        std::vector<SymbolID> lhsNodes {};
+        std::vector<PatternEdge> lhsEdges {};
+        std::vector<SymbolID> rhsNodes {};
+        std::vector<PatternEdge> rhsEdges {};
+        std::vector<uint32_t> keptAs {}; // Per lhs node the rhs node it becomes, or NONE
+        std::vector<uint32_t> keptFrom {}; // Per rhs node the lhs node it comes from, or NONE
+        std::vector<SearchPlan> plans {}; // One per lhs node as root
+    };
+
+    struct Match {
+        uint32_t rule = NONE;
+        uint32_t slot = NONE; // Position in _ruleMatches[rule]
+        std::vector<VertexId> vertices {}; // Host vertex per lhs node
+    };
+
+    struct VertexInfo {
+        uint32_t labelSlot = NONE; // Position in _labelVertices[label]
+        uint32_t stamp = 0; // Equal to _stamp when created or relabeled by the current rewrite
+        std::vector<MatchId> matches {}; // Can hold matches that were removed already
+    };
+
+    void ConvertRules(const std::vector<GraphRule>& rules);
+    [[nodiscard]] static SearchPlan BuildPlan(const RuleInternal& rule, uint32_t root);
+
+    void Apply(MatchId matchId);
+
+    // Finds the matches of rule with lhs node root bound to start. With onlyNew set, matches that bind a
+    // lower lhs node to a vertex touched by the current rewrite are skipped, they are found from that node.
+    void Search(uint32_t rule, uint32_t root, VertexId start, bool onlyNew);
+    void Extend(uint32_t rule, uint32_t root, size_t depth, bool onlyNew);
+    [[nodiscard]] bool CanBind(const RuleInternal& rule, const SearchPlan& plan, size_t depth, VertexId vertex, uint32_t root, bool onlyNew) const;
+
+    void AddMatch(uint32_t rule);
+    void RemoveMatch(MatchId matchId);
+    void RemoveMatchesAt(VertexId vertex);
+
+    [[nodiscard]] EdgeId FindEdge(VertexId v1, VertexId v2, SymbolID label) const;
+    [[nodiscard]] SymbolID Label(VertexId vertex) const { return _graph.GetVertex(vertex)._data; }
+    VertexInfo& Info(VertexId vertex);
+    void IndexVertex(VertexId vertex);
+    void UnindexVertex(VertexId vertex);
+
+    SymbolRegistry& _registry;
+    std::vector<RuleInternal> _rules {};
+    AliasTable _ruleTable {};
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> _labelRoots {}; // Per label the (rule, lhs node) pairs with it
+
+    LabelGraph _graph {};
+    std::vector<VertexInfo> _vertexInfo {}; // Indexed by VertexId::index
+    std::vector<std::vector<VertexId>> _labelVertices {}; // Indexed by label
+    uint32_t _stamp = 0;
+
+    SlotMap<Match> _matches {};
+    std::vector<std::vector<MatchId>> _ruleMatches {};
+    std::vector<uint32_t> _activeRules {};
+    std::vector<uint32_t> _activePosition {};
+
+    // Scratch space for the search and for rewrites
+    std::vector<VertexId> _binding {};
+    std::vector<std::vector<VertexId>> _candidates {};
+    std::vector<VertexId> _rewriteVertices {};
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The object that the user creates for graph rewriting rules.
+// Nodes are referred to by their index in lhsNodes or rhsNodes, edges are undirected.
+struct GraphRule {
+    struct Edge {
+        uint32_t from;
+        uint32_t to;
+        std::string label {}; // An empty lhs label matches any edge, an empty rhs label creates an unlabeled edge
+    };
+
+    std::vector<std::string> lhsNodes;
+    std::vector<Edge> lhsEdges;
+    std::vector<std::string> rhsNodes;
+    std::vector<Edge> rhsEdges;
+    // (lhs node, rhs node) pairs that survive the rewrite and only take the rhs label.
+    // Other matched nodes are removed with all their edges, matched lhs edges are always removed.
+    std::vector<std::pair<uint32_t, uint32_t>> kept;
+    float weight = 1.0f; // Relative probability of picking this rule
+};
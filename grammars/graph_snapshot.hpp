@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "slot_map.hpp"
+
+// Immutable compressed sparse row copy of a Graph, made with Graph::Snapshot().
+// Vertices and edges are renumbered densely from 0, the original ids can be looked up in both directions.
+// Nothing is modified after construction, so one snapshot can be shared between threads.
+class GraphSnapshot {
+public:
+    using Index = uint32_t;
+
+    static constexpr Index INVALID_INDEX = std::numeric_limits<Index>::max();
+
+    struct Edge {
+        Index source;
+        Index target;
+    };
+
+    GraphSnapshot() = default;
+
+    // offsets has one entry per vertex plus one, neighbours and incidentEdges hold the adjacency of vertex v
+    // in [offsets[v], offsets[v + 1]). An edge appears in the adjacency of both endpoints.
+    GraphSnapshot(std::vector<Index> offsets, std::vector<Index> neighbours, std::vector<Index> incidentEdges,
+        std::vector<Edge> edges, std::vector<float> weights, std::vector<SlotId> vertexIds, std::vector<SlotId> edgeIds)
+        : _offsets(std::move(offsets)),
+          _neighbours(std::move(neighbours)),
+          _incidentEdges(std::move(incidentEdges)),
+          _edges(std::move(edges)),
+          _weights(std::move(weights)),
+          _vertexIds(std::move(vertexIds)),
+          _edgeIds(std::move(edgeIds)) {
+        for (Index v = 0; v < _vertexIds.size(); v++) {
+            if (_vertexIds[v].index >= _vertexSlots.size()) {
+                _vertexSlots.resize(_vertexIds[v].index + 1, INVALID_INDEX);
+            }
+            _vertexSlots[_vertexIds[v].index] = v;
+        }
+    }
+
+    [[nodiscard]] size_t VertexCount() const { return _vertexIds.size(); }
+    [[nodiscard]] size_t EdgeCount() const { return _edges.size(); }
+
+    [[nodiscard]] std::span<const Index> Neighbours(Index v) const {
+        return std::span<const Index>(_neighbours).subspan(_offsets[v], _offsets[v + 1] - _offsets[v]);
+    }
+
+    // Parallel to Neighbours(v)
+    [[nodiscard]] std::span<const Index> IncidentEdges(Index v) const {
+        return std::span<const Index>(_incidentEdges).subspan(_offsets[v], _offsets[v + 1] - _offsets[v]);
+    }
+
+    [[nodiscard]] Index Degree(Index v) const { return _offsets[v + 1] - _offsets[v]; }
+
+    [[nodiscard]] const Edge& GetEdge(Index e) const { return _edges[e]; }
+    [[nodiscard]] std::span<const Edge> Edges() const { return _edges; }
+    [[nodiscard]] float Weight(Index e) const { return _weights[e]; }
+    [[nodiscard]] std::span<const float> Weights() const { return _weights; }
+
+    [[nodiscard]] SlotId OriginalVertex(Index v) const { return _vertexIds[v]; }
+    [[nodiscard]] SlotId OriginalEdge(Index e) const { return _edgeIds[e]; }
+
+    // INVALID_INDEX when the vertex was not part of the graph at the time of the snapshot
+    [[nodiscard]] Index DenseVertex(SlotId v) const {
+        if (v.index >= _vertexSlots.size() || _vertexSlots[v.index] == INVALID_INDEX || _vertexIds[_vertexSlots[v.index]] != v) {
+            return INVALID_INDEX;
+        }
+        return _vertexSlots[v.index];
+    }
+
+private:
+    std::vector<Index> _offsets {0};
+    std::vector<Index> _neighbours {};
+    std::vector<Index> _incidentEdges {};
+    std::vector<Edge> _edges {};
+    std::vector<float> _weights {};
+
+    std::vector<SlotId> _vertexIds {};
+    std::vector<SlotId> _edgeIds {};
+    std::vector<Index> _vertexSlots {}; // Indexed by SlotId::index
+};
@@ -0,0 +1,92 @@
+#include "mission_layout.hpp"
+#include "parallelFor.hpp"
+
+#include <algorithm>
+#include <thread>
+
+using DungeonGenerator::RoomType;
+
+MissionLayout LayMission(DungeonGenerator::Dungeon& dungeon, std::span<const MissionLayoutSettings::SymbolID> mission,
+    const MissionLayoutSettings& settings) {
+    MissionLayout layout;
+    layout.rooms.assign(mission.size(), MissionLayout::UNPLACED);
+
+    auto& vertices = dungeon.mVertices;
+    if (vertices.empty()) {
+        return layout;
+    }
+
+    const auto startRoom = std::ranges::find(vertices, RoomType::START, &DungeonGenerator::DungeonVertex::mType);
+    const auto start = startRoom == vertices.end() ? 0u : static_cast<uint32_t>(startRoom - vertices.begin());
+
+    // Breadth first from START, the visiting order doubles as the queue
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> parent(vertices.size(), NONE);
+    std::vector<uint32_t> order;
+    order.reserve(vertices.size());
+    order.emplace_back(start);
+    parent[start] = start;
+    for (size_t head = 0; head < order.size(); head++) {
+        for (uint32_t neighbour : vertices[order[head]].mConnections) {
+            if (parent[neighbour] == NONE) {
+                parent[neighbour] = order[head];
+                order.emplace_back(neighbour);
+            }
+        }
+    }
+
+    // The last room visited is as far from START as any
+    for (uint32_t room = order.back(); room != start; room = parent[room]) {
+        layout.spine.emplace_back(room);
+    }
+    layout.spine.emplace_back(start);
+    std::ranges::reverse(layout.spine);
+
+    if (mission.size() <= layout.spine.size()) {
+        // Spread evenly, the first step at START and the last at the end of the spine
+        const size_t last = mission.size() - 1;
+        for (size_t step = 0; step < mission.size(); step++) {
+            const size_t position = last == 0 ? 0 : (step * (layout.spine.size() - 1) + last / 2) / last;
+            layout.rooms[step] = layout.spine[position];
+        }
+    } else {
+        const size_t placed = std::min(mission.size(), order.size());
+        std::copy_n(order.begin(), placed, layout.rooms.begin());
+    }
+
+    if (settings.fillType.has_value()) {
+        for (auto& vertex : vertices) {
+            if (vertex.mType != RoomType::START && vertex.mType != RoomType::BOSS) {
+                vertex.mType = *settings.fillType;
+            }
+        }
+    }
+
+    for (size_t step = 0; step < mission.size(); step++) {
+        const auto symbol = mission[step];
+        if (layout.rooms[step] == MissionLayout::UNPLACED || symbol >= settings.symbolTypes.size()
+            || settings.symbolTypes[symbol] == RoomType::NUM_TYPES) {
+            continue;
+        }
+        vertices[layout.rooms[step]].mType = settings.symbolTypes[symbol];
+    }
+
+    return layout;
+}
+
+std::vector<MissionDungeon> GenerateMissionDungeons(const Grammar& grammar, std::span<const MissionJob> jobs,
+    const MissionLayoutSettings& settings, const ExecutionSettings& grammarSettings, unsigned threadCount) {
+    std::vector<MissionDungeon> results(jobs.size());
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    DungeonGenerator::ParallelForEach(jobs.size(), threadCount, [&](size_t i) {
+        auto& result = results[i];
+        result.dungeon = DungeonGenerator::Dungeon(jobs[i].generationData);
+        result.mission = grammar.Expand(jobs[i].startString, jobs[i].grammarSeed, grammarSettings);
+        result.layout = LayMission(result.dungeon, result.mission, settings);
+    });
+
+    return results;
+}
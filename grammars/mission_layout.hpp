@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "dungeonerator.hpp"
+#include "grammar.hpp"
+
+// Lays a mission, a symbol string made by a Grammar, onto the rooms of a generated dungeon.
+// Mission steps are placed in order along the path from START to the room farthest away from it.
+// Missions that are longer than that path are placed in breadth first order from START instead,
+// so later steps are never closer to START than earlier ones.
+struct MissionLayoutSettings {
+    using SymbolID = SymbolRegistry::SymbolID;
+
+    // Room type per SymbolID, symbols outside of it or mapped to NUM_TYPES keep the fill type
+    std::vector<DungeonGenerator::RoomType> symbolTypes {};
+    // Type of the rooms without a mission step, empty keeps the generated types.
+    // START and BOSS rooms keep their type unless a mission step lands on them.
+    std::optional<DungeonGenerator::RoomType> fillType {};
+};
+
+struct MissionLayout {
+    static constexpr uint32_t UNPLACED = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> rooms {}; // Room of every mission step, UNPLACED when the dungeon has too few rooms
+    std::vector<uint32_t> spine {}; // Rooms of the path from START the mission was laid along
+};
+
+// Assigns the room types of the dungeon. The mission starts in the START room, or room 0 when no room has that type.
+// Only mType changes. mDifficulty and the metrics are not recomputed, so mMetrics.mStartBossDistance still refers
+// to the generated START and BOSS when the mission moves them.
+MissionLayout LayMission(DungeonGenerator::Dungeon& dungeon, std::span<const MissionLayoutSettings::SymbolID> mission,
+    const MissionLayoutSettings& settings);
+
+struct MissionJob {
+    DungeonGenerator::GenerationData generationData {};
+    std::vector<SymbolRegistry::SymbolID> startString {};
+    uint64_t grammarSeed = 0;
+};
+
+struct MissionDungeon {
+    DungeonGenerator::Dungeon dungeon {};
+    std::vector<SymbolRegistry::SymbolID> mission {};
+    MissionLayout layout {};
+};
+
+// Generates the dungeon, expands the mission with Grammar::Expand and lays it out for every job.
+// Results do not depend on the number of threads, 0 uses all hardware threads.
+std::vector<MissionDungeon> GenerateMissionDungeons(const Grammar& grammar, std::span<const MissionJob> jobs,
+    const MissionLayoutSettings& settings, const ExecutionSettings& grammarSettings = {}, unsigned threadCount = 0);
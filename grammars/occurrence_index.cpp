@@ -0,0 +1,198 @@
+#include "occurrence_index.hpp"
+
+#include <algorithm>
+
+void OccurrenceIndex::Assign(std::span<const SymbolID> symbols) {
+    _nodes.clear();
+    _freeNodes = NIL;
+    _head = NIL;
+    _size = 0;
+
+    _occurrences.clear();
+    _freeOccurrences = NIL;
+    for (auto& occurrences : _ruleOccurrences) {
+        occurrences.clear();
+    }
+    _activeRules.clear();
+    std::fill(_activePosition.begin(), _activePosition.end(), NIL);
+
+    _nodes.reserve(symbols.size());
+    NodeId prev = NIL;
+    for (SymbolID symbol : symbols) {
+        const NodeId node = NewNode(symbol);
+        _nodes[node].prev = prev;
+        if (prev == NIL) {
+            _head = node;
+        } else {
+            _nodes[prev].next = node;
+        }
+        prev = node;
+    }
+    _size = symbols.size();
+
+    if (_head != NIL) {
+        Scan(_head, _size);
+    }
+}
+
+void OccurrenceIndex::Apply(const Match& match, std::span<const SymbolID> replacement) {
+    const size_t length = _matcher.PatternLength(match.rule);
+
+    // Occurrences that start up to MaxPatternLength - 1 nodes before the match can overlap it
+    NodeId windowStart = match.start;
+    size_t back = 0;
+    while (back + 1 < _matcher.MaxPatternLength() && _nodes[windowStart].prev != NIL) {
+        windowStart = _nodes[windowStart].prev;
+        ++back;
+    }
+
+    NodeId node = windowStart;
+    for (size_t i = 0; i < back + length; i++) {
+        RemoveOccurrencesAt(node);
+        node = _nodes[node].next;
+    }
+
+    const NodeId before = _nodes[match.start].prev;
+    const NodeId after = node;
+
+    node = match.start;
+    for (size_t i = 0; i < length; i++) {
+        const NodeId next = _nodes[node].next;
+        FreeNode(node);
+        node = next;
+    }
+
+    NodeId prev = before;
+    NodeId firstInserted = NIL;
+    for (SymbolID symbol : replacement) {
+        const NodeId inserted = NewNode(symbol);
+        _nodes[inserted].prev = prev;
+        if (prev == NIL) {
+            _head = inserted;
+        } else {
+            _nodes[prev].next = inserted;
+        }
+        if (firstInserted == NIL) {
+            firstInserted = inserted;
+        }
+        prev = inserted;
+    }
+
+    if (prev == NIL) {
+        _head = after;
+    } else {
+        _nodes[prev].next = after;
+    }
+    if (after != NIL) {
+        _nodes[after].prev = prev;
+    }
+
+    _size = _size - length + replacement.size();
+
+    const NodeId scanStart = back > 0 ? windowStart : (firstInserted != NIL ? firstInserted : after);
+    if (scanStart != NIL) {
+        Scan(scanStart, back + replacement.size());
+    }
+}
+
+void OccurrenceIndex::CopyTo(std::vector<SymbolID>& out) const {
+    out.clear();
+    out.reserve(_size);
+    for (NodeId node = _head; node != NIL; node = _nodes[node].next) {
+        out.emplace_back(_nodes[node].symbol);
+    }
+}
+
+OccurrenceIndex::NodeId OccurrenceIndex::NewNode(SymbolID symbol) {
+    NodeId node = _freeNodes;
+    if (node == NIL) {
+        node = static_cast<NodeId>(_nodes.size());
+        _nodes.emplace_back();
+    } else {
+        _freeNodes = _nodes[node].next;
+    }
+
+    _nodes[node] = Node {symbol, _matcher.SymbolIndex(symbol), NIL, NIL, NIL};
+    return node;
+}
+
+void OccurrenceIndex::FreeNode(NodeId node) {
+    _nodes[node].next = _freeNodes;
+    _freeNodes = node;
+}
+
+void OccurrenceIndex::AddOccurrence(uint32_t rule, NodeId node) {
+    OccurrenceId occurrence = _freeOccurrences;
+    if (occurrence == NIL) {
+        occurrence = static_cast<OccurrenceId>(_occurrences.size());
+        _occurrences.emplace_back();
+    } else {
+        _freeOccurrences = _occurrences[occurrence].nextAtNode;
+    }
+
+    auto& list = _ruleOccurrences[rule];
+    _occurrences[occurrence] = Occurrence {rule, node, _nodes[node].occurrences, static_cast<uint32_t>(list.size())};
+    _nodes[node].occurrences = occurrence;
+    list.emplace_back(occurrence);
+
+    if (list.size() == 1) {
+        _activePosition[rule] = static_cast<uint32_t>(_activeRules.size());
+        _activeRules.emplace_back(rule);
+    }
+}
+
+void OccurrenceIndex::RemoveOccurrencesAt(NodeId node) {
+    OccurrenceId occurrence = _nodes[node].occurrences;
+
+    while (occurrence != NIL) {
+        const Occurrence removed = _occurrences[occurrence];
+
+        // Swap and pop from the rule list
+        auto& list = _ruleOccurrences[removed.rule];
+        const OccurrenceId moved = list.back();
+        list[removed.slot] = moved;
+        _occurrences[moved].slot = removed.slot;
+        list.pop_back();
+
+        if (list.empty()) {
+            const uint32_t position = _activePosition[removed.rule];
+            const uint32_t movedRule = _activeRules.back();
+            _activeRules[position] = movedRule;
+            _activePosition[movedRule] = position;
+            _activeRules.pop_back();
+            _activePosition[removed.rule] = NIL;
+        }
+
+        _occurrences[occurrence].nextAtNode = _freeOccurrences;
+        _freeOccurrences = occurrence;
+        occurrence = removed.nextAtNode;
+    }
+
+    _nodes[node].occurrences = NIL;
+}
+
+void OccurrenceIndex::Scan(NodeId first, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const size_t windowSize = std::max<size_t>(_matcher.MaxPatternLength(), 1);
+    _window.resize(windowSize);
+
+    // Matches starting in the first count nodes end at most MaxPatternLength - 1 nodes later
+    const size_t limit = count + windowSize - 1;
+
+    RuleMatcher::State state = RuleMatcher::START;
+    size_t i = 0;
+    for (NodeId node = first; node != NIL && i < limit; node = _nodes[node].next, i++) {
+        state = _matcher.Step(state, _nodes[node].symbolIndex);
+        _window[i % windowSize] = node;
+
+        for (uint32_t rule : _matcher.Matches(state)) {
+            const size_t start = i + 1 - _matcher.PatternLength(rule);
+            if (start < count) {
+                AddOccurrence(rule, _window[start % windowSize]);
+            }
+        }
+    }
+}
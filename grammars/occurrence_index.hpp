@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "rule_matcher.hpp"
+
+// Working string for indexed grammar execution.
+// Keeps every occurrence of every rule lhs, updated around each rewrite site, so an applicable rule
+// and location can be picked without searching the string.
+class OccurrenceIndex {
+public:
+    using SymbolID = SymbolRegistry::SymbolID;
+    using NodeId = uint32_t;
+    using OccurrenceId = uint32_t;
+
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+    struct Match {
+        uint32_t rule = NIL;
+        NodeId start = NIL;
+    };
+
+    explicit OccurrenceIndex(const RuleMatcher& matcher)
+        : _matcher(matcher), _ruleOccurrences(matcher.PatternCount()), _activePosition(matcher.PatternCount(), NIL) {
+    }
+
+    void Assign(std::span<const SymbolID> symbols);
+
+    // Rules that currently have at least one occurrence
+    [[nodiscard]] std::span<const uint32_t> ActiveRules() const { return _activeRules; }
+    [[nodiscard]] size_t OccurrenceCount(uint32_t rule) const { return _ruleOccurrences[rule].size(); }
+    [[nodiscard]] Match GetOccurrence(uint32_t rule, size_t i) const {
+        return {rule, _occurrences[_ruleOccurrences[rule][i]].node};
+    }
+
+    // Replaces the lhs of the matched rule with the replacement and updates the occurrences around it
+    void Apply(const Match& match, std::span<const SymbolID> replacement);
+
+    [[nodiscard]] size_t Size() const { return _size; }
+    void CopyTo(std::vector<SymbolID>& out) const;
+
+private:
+    struct Node {
+        SymbolID symbol {};
+        uint32_t symbolIndex = 0;
+        NodeId prev = NIL;
+        NodeId next = NIL;
+        OccurrenceId occurrences = NIL; // Head of the occurrences starting at this node
+    };
+
+    struct Occurrence {
+        uint32_t rule = NIL;
+        NodeId node = NIL;
+        OccurrenceId nextAtNode = NIL;
+        uint32_t slot = NIL; // Position in _ruleOccurrences[rule]
+    };
+
+    NodeId NewNode(SymbolID symbol);
+    void FreeNode(NodeId node);
+
+    void AddOccurrence(uint32_t rule, NodeId node);
+    void RemoveOccurrencesAt(NodeId node);
+
+    // Runs the automaton from first and records matches that start within the first count nodes
+    void Scan(NodeId first, size_t count);
+
+    const RuleMatcher& _matcher;
+
+    std::vector<Node> _nodes {};
+    NodeId _freeNodes = NIL;
+    NodeId _head = NIL;
+    size_t _size = 0;
+
+    std::vector<Occurrence> _occurrences {};
+    OccurrenceId _freeOccurrences = NIL;
+    std::vector<std::vector<OccurrenceId>> _ruleOccurrences {};
+
+    std::vector<uint32_t> _activeRules {};
+    std::vector<uint32_t> _activePosition {};
+
+    std::vector<NodeId> _window {}; // Ring buffer of the last scanned nodes
+};
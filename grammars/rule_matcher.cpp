@@ -0,0 +1,86 @@
+#include "rule_matcher.hpp"
+
+#include <algorithm>
+#include <queue>
+
+RuleMatcher::RuleMatcher(const std::vector<std::vector<SymbolID>>& patterns) {
+    // Index 0 is reserved for symbols that appear in no pattern
+    for (const auto& pattern : patterns) {
+        for (SymbolID symbol : pattern) {
+            if (symbol >= _symbolIndices.size()) {
+                _symbolIndices.resize(symbol + 1, 0);
+            }
+            if (_symbolIndices[symbol] == 0) {
+                _symbolIndices[symbol] = _alphabetSize++;
+            }
+        }
+    }
+
+    // Build the trie, missing transitions are marked with the start state and filled in below
+    std::vector<std::vector<uint32_t>> stateOutputs(1);
+    _transitions.assign(_alphabetSize, START);
+
+    for (uint32_t p = 0; p < patterns.size(); p++) {
+        _patternLengths.emplace_back(patterns[p].size());
+        _maxPatternLength = std::max(_maxPatternLength, patterns[p].size());
+
+        if (patterns[p].empty()) {
+            continue;
+        }
+
+        State state = START;
+        for (SymbolID symbol : patterns[p]) {
+            const uint32_t index = SymbolIndex(symbol);
+            State next = Step(state, index);
+            if (next == START) {
+                next = static_cast<State>(stateOutputs.size());
+                _transitions[state * _alphabetSize + index] = next;
+                _transitions.resize(_transitions.size() + _alphabetSize, START);
+                stateOutputs.emplace_back();
+            }
+            state = next;
+        }
+        stateOutputs[state].emplace_back(p);
+    }
+
+    // Breadth first over the trie, completing the transition table with failure transitions
+    const size_t stateCount = stateOutputs.size();
+    std::vector<State> failure(stateCount, START);
+    std::vector<bool> isTrieEdge(_transitions.size(), false);
+    for (size_t i = 0; i < _transitions.size(); i++) {
+        isTrieEdge[i] = _transitions[i] != START;
+    }
+
+    std::queue<State> queue;
+    for (uint32_t index = 0; index < _alphabetSize; index++) {
+        if (isTrieEdge[index]) {
+            queue.push(_transitions[index]);
+        }
+    }
+
+    while (!queue.empty()) {
+        const State state = queue.front();
+        queue.pop();
+
+        // Dictionary suffix outputs, the failure state was completed before this state
+        const auto& inherited = stateOutputs[failure[state]];
+        stateOutputs[state].insert(stateOutputs[state].end(), inherited.begin(), inherited.end());
+
+        for (uint32_t index = 0; index < _alphabetSize; index++) {
+            const size_t slot = state * _alphabetSize + index;
+            if (isTrieEdge[slot]) {
+                const State child = _transitions[slot];
+                failure[child] = Step(failure[state], index);
+                queue.push(child);
+            } else {
+                _transitions[slot] = Step(failure[state], index);
+            }
+        }
+    }
+
+    _outputOffsets.assign(1, 0);
+    for (const auto& outputs : stateOutputs) {
+        _outputs.insert(_outputs.end(), outputs.begin(), outputs.end());
+        _outputOffsets.emplace_back(static_cast<uint32_t>(_outputs.size()));
+    }
+}
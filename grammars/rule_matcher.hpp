@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "symbol_registry.hpp"
+
+// Aho-Corasick automaton over the left hand sides of a set of rules.
+// Feeding a string one symbol at a time reports every rule whose lhs ends at that symbol.
+class RuleMatcher {
+public:
+    using SymbolID = SymbolRegistry::SymbolID;
+    using State = uint32_t;
+
+    RuleMatcher() = default;
+    explicit RuleMatcher(const std::vector<std::vector<SymbolID>>& patterns);
+
+    static constexpr State START = 0;
+
+    // Dense index of a symbol inside the automaton, symbols that appear in no pattern share one index
+    [[nodiscard]] uint32_t SymbolIndex(SymbolID symbol) const {
+        return symbol < _symbolIndices.size() ? _symbolIndices[symbol] : 0;
+    }
+
+    [[nodiscard]] State Step(State state, uint32_t symbolIndex) const {
+        return _transitions[state * _alphabetSize + symbolIndex];
+    }
+
+    // Patterns that end after reaching this state
+    [[nodiscard]] std::span<const uint32_t> Matches(State state) const {
+        return std::span<const uint32_t>(_outputs).subspan(_outputOffsets[state], _outputOffsets[state + 1] - _outputOffsets[state]);
+    }
+
+    [[nodiscard]] size_t PatternLength(uint32_t pattern) const { return _patternLengths[pattern]; }
+    [[nodiscard]] size_t MaxPatternLength() const { return _maxPatternLength; }
+    [[nodiscard]] size_t PatternCount() const { return _patternLengths.size(); }
+
+private:
+    std::vector<uint32_t> _symbolIndices {}; // Indexed by SymbolID
+    uint32_t _alphabetSize = 1;
+
+    std::vector<State> _transitions {}; // state * _alphabetSize + symbol index
+    std::vector<uint32_t> _outputOffsets {0, 0};
+    std::vector<uint32_t> _outputs {};
+
+    std::vector<size_t> _patternLengths {};
+    size_t _maxPatternLength = 0;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Handle into a SlotMap, the generation detects use of a handle whose element was removed
+struct SlotId {
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool Valid() const { return index != INVALID_INDEX; }
+    bool operator==(const SlotId&) const = default;
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const SlotId& id) {
+    return stream << id.index << ":" << id.generation;
+}
+
+// Values live in a dense array, handles go through a slot table with a free list.
+// Insert and Erase are O(1), iteration is linear over contiguous memory.
+template <typename T>
+class SlotMap {
+public:
+    SlotId Insert(T value) {
+        uint32_t slot = _freeHead;
+        if (slot == SlotId::INVALID_INDEX) {
+            slot = static_cast<uint32_t>(_slots.size());
+            _slots.emplace_back();
+        } else {
+            _freeHead = _slots[slot].dense;
+        }
+
+        _slots[slot].dense = static_cast<uint32_t>(_values.size());
+        _values.emplace_back(std::move(value));
+        _denseToSlot.emplace_back(slot);
+
+        return {slot, _slots[slot].generation};
+    }
+
+    bool Erase(SlotId id) {
+        if (!Contains(id)) {
+            return false;
+        }
+
+        // Move the last value into the hole
+        const uint32_t dense = _slots[id.index].dense;
+        const uint32_t last = static_cast<uint32_t>(_values.size() - 1);
+        if (dense != last) {
+            _values[dense] = std::move(_values[last]);
+            _denseToSlot[dense] = _denseToSlot[last];
+            _slots[_denseToSlot[dense]].dense = dense;
+        }
+        _values.pop_back();
+        _denseToSlot.pop_back();
+
+        ++_slots[id.index].generation;
+        _slots[id.index].dense = _freeHead;
+        _freeHead = id.index;
+        return true;
+    }
+
+    [[nodiscard]] bool Contains(SlotId id) const {
+        return id.index < _slots.size() && _slots[id.index].generation == id.generation && _slots[id.index].dense < _values.size()
+            && _denseToSlot[_slots[id.index].dense] == id.index;
+    }
+
+    T* Find(SlotId id) { return Contains(id) ? &_values[_slots[id.index].dense] : nullptr; }
+    const T* Find(SlotId id) const { return Contains(id) ? &_values[_slots[id.index].dense] : nullptr; }
+
+    T& At(SlotId id) {
+        if (!Contains(id)) {
+            throw std::out_of_range("SlotMap::At with a stale or invalid id");
+        }
+        return _values[_slots[id.index].dense];
+    }
+
+    const T& At(SlotId id) const {
+        if (!Contains(id)) {
+            throw std::out_of_range("SlotMap::At with a stale or invalid id");
+        }
+        return _values[_slots[id.index].dense];
+    }
+
+    void Reserve(size_t count) {
+        _values.reserve(count);
+        _denseToSlot.reserve(count);
+        _slots.reserve(count);
+    }
+
+    void Clear() {
+        for (uint32_t slot : _denseToSlot) {
+            ++_slots[slot].generation;
+        }
+        _freeHead = SlotId::INVALID_INDEX;
+        for (uint32_t slot = 0; slot < _slots.size(); slot++) {
+            _slots[slot].dense = _freeHead;
+            _freeHead = slot;
+        }
+        _values.clear();
+        _denseToSlot.clear();
+    }
+
+    [[nodiscard]] size_t Size() const { return _values.size(); }
+    [[nodiscard]] bool Empty() const { return _values.empty(); }
+
+    // Handle of the value at a dense position
+    [[nodiscard]] SlotId IdAt(size_t dense) const {
+        const uint32_t slot = _denseToSlot[dense];
+        return {slot, _slots[slot].generation};
+    }
+
+    // Dense position of a valid handle, stable until the next Erase
+    [[nodiscard]] size_t DenseIndex(SlotId id) const { return _slots[id.index].dense; }
+
+    [[nodiscard]] std::span<T> Values() { return _values; }
+    [[nodiscard]] std::span<const T> Values() const { return _values; }
+
+    // Iterates over (id, value) pairs in dense order
+    template <bool Const>
+    class Iterator {
+    public:
+        using Map = std::conditional_t<Const, const SlotMap, SlotMap>;
+        using Value = std::conditional_t<Const, const T, T>;
+
+        Iterator(Map* map, size_t dense) : _map(map), _dense(dense) {}
+
+        std::pair<SlotId, Value&> operator*() const { return {_map->IdAt(_dense), _map->_values[_dense]}; }
+        Iterator& operator++() {
+            ++_dense;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return _dense == other._dense; }
+
+    private:
+        Map* _map;
+        size_t _dense;
+    };
+
+    Iterator<false> begin() { return {this, 0}; }
+    Iterator<false> end() { return {this, _values.size()}; }
+    Iterator<true> begin() const { return {this, 0}; }
+    Iterator<true> end() const { return {this, _values.size()}; }
+
+private:
+    struct Slot {
+        uint32_t dense = SlotId::INVALID_INDEX; // Next free slot while the slot is unused
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> _values {};
+    std::vector<uint32_t> _denseToSlot {};
+    std::vector<Slot> _slots {};
+    uint32_t _freeHead = SlotId::INVALID_INDEX;
+};
@@ -6,11 +6,14 @@
 #include "symbol_registry.hpp"
 
 SymbolRegistry::SymbolID SymbolRegistry::AddSymbol(const SymbolData &data) {
-    const auto id = std::hash<std::string>{}(data.name);
-    if (registry.contains(id)) {
-        std::cout << "Tried adding multiple symbols with the same name" << data.name.data() << std::endl;
+    const auto id = static_cast<SymbolID>(_symbols.size());
+    const auto [it, inserted] = _lookup.try_emplace(data.name, id);
+    if (!inserted) {
+        std::cout << "Tried adding multiple symbols with the same name: " << data.name << std::endl;
+        return it->second;
     }
-    registry[id] = data;
+
+    _symbols.emplace_back(data);
 
     if (data.terminal) {
         _alphabet.emplace_back(id);
@@ -22,29 +25,28 @@ SymbolRegistry::SymbolID SymbolRegistry::AddSymbol(const SymbolData &data) {
     return id;
 }
 
-SymbolRegistry::SymbolID SymbolRegistry::GetSymbol(const std::string_view &name) const {
-    const auto id = std::hash<std::string>{}(name.data());
-    if (!registry.contains(id)) {
-        std::cout << "Requested non-existing symbol: " << name.data() << std::endl;
-
-        return 0;
+SymbolRegistry::SymbolID SymbolRegistry::GetSymbol(std::string_view name) const {
+    const auto it = _lookup.find(name);
+    if (it == _lookup.end()) {
+        std::cout << "Requested non-existing symbol: " << name << std::endl;
+        return INVALID_SYMBOL;
     }
-    return id;
+    return it->second;
 }
 
-std::optional<const SymbolData> SymbolRegistry::GetSymbolData(const SymbolID id) {
-    if (!registry.contains(id)) {
+const SymbolData* SymbolRegistry::GetSymbolData(const SymbolID id) const {
+    if (id >= _symbols.size()) {
         std::cout << "Tried requesting symbol data from non existing symbol: " << id << std::endl;
-        return std::nullopt;
+        return nullptr;
     }
-    return registry[id];
+    return &_symbols[id];
 }
 
-std::optional<const SymbolData> SymbolRegistry::GetSymbolData(const std::string_view &name) {
-    const auto id = std::hash<std::string>{}(name.data());
-    if (!registry.contains(id)) {
-        std::cout << "Tried to request symbol data from non existing symbol: " << name.data() << std::endl;
-        return std::nullopt;
+const SymbolData* SymbolRegistry::GetSymbolData(std::string_view name) const {
+    const auto it = _lookup.find(name);
+    if (it == _lookup.end()) {
+        std::cout << "Tried to request symbol data from non existing symbol: " << name << std::endl;
+        return nullptr;
     }
-    return registry[id];
+    return &_symbols[it->second];
 }
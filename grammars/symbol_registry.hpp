@@ -1,25 +1,43 @@
 #pragma once
 
-#include <optional>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "symbol_data.hpp"
 
 class SymbolRegistry {
 public:
-    using SymbolID = size_t;
+    // Dense index into the registry, assigned in the order symbols are added
+    using SymbolID = uint32_t;
+
+    static constexpr SymbolID INVALID_SYMBOL = std::numeric_limits<SymbolID>::max();
 
     SymbolID AddSymbol(const SymbolData& data);
-    [[nodiscard]] SymbolID GetSymbol(const std::string_view& name) const ;
-    std::optional<const SymbolData> GetSymbolData(SymbolID id);
-    std::optional<const SymbolData> GetSymbolData(const std::string_view& name);
+    [[nodiscard]] SymbolID GetSymbol(std::string_view name) const;
+    // nullptr when the symbol does not exist
+    [[nodiscard]] const SymbolData* GetSymbolData(SymbolID id) const;
+    [[nodiscard]] const SymbolData* GetSymbolData(std::string_view name) const;
+
+    [[nodiscard]] size_t Size() const { return _symbols.size(); }
 
-    const std::vector<SymbolID>& GetAlphabet() { return _alphabet; }
-    const std::vector<SymbolID>& GetNonTerminals() { return _nonTerminals; }
+    [[nodiscard]] std::span<const SymbolID> GetAlphabet() const { return _alphabet; }
+    [[nodiscard]] std::span<const SymbolID> GetNonTerminals() const { return _nonTerminals; }
 
 private:
-    std::unordered_map<SymbolID, SymbolData> registry{};
+    // Lets the lookup take a string_view without building a std::string
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::vector<SymbolData> _symbols{};
+    std::unordered_map<std::string, SymbolID, StringHash, std::equal_to<>> _lookup{};
 
     std::vector<SymbolID> _alphabet{};
     std::vector<SymbolID> _nonTerminals{};
-};
\ No newline at end of file
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Like assert, but also checked in release builds and the test keeps running after a failure
+inline int gFailures = 0;
+
+#define CHECK(condition)                                                                       \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);          \
+            ++gFailures;                                                                       \
+        }                                                                                      \
+    } while (false)
+
+inline int TestResult()
+{
+    if (gFailures != 0) {
+        std::printf("%d checks failed\n", gFailures);
+    }
+    return gFailures == 0 ? 0 : 1;
+}
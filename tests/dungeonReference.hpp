@@ -0,0 +1,39 @@
+#pragma once
+
+#include "dungeonerator.hpp"
+
+#include <cmath>
+#include <queue>
+
+// Plain reference computations the tests compare the generator against
+
+inline float RoomDistance(const DungeonGenerator::Dungeon& dungeon, std::uint32_t a, std::uint32_t b)
+{
+    const auto& vertices = dungeon.mVertices;
+    return std::hypot(vertices[a].mPx - vertices[b].mPx, vertices[a].mPy - vertices[b].mPy);
+}
+
+// Corridor lengths from source to every room, PathHierarchy::UNREACHABLE for rooms in other components
+inline std::vector<float> Dijkstra(const DungeonGenerator::Dungeon& dungeon, std::uint32_t source)
+{
+    std::vector<float> distance(dungeon.mVertices.size(), DungeonGenerator::PathHierarchy::UNREACHABLE);
+    using Entry = std::pair<float, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+    distance[source] = 0.0f;
+    open.emplace(0.0f, source);
+    while (!open.empty()) {
+        const auto [current, room] = open.top();
+        open.pop();
+        if (current > distance[room]) {
+            continue;
+        }
+        for (std::uint32_t neighbour : dungeon.mVertices[room].mConnections) {
+            const float next = current + RoomDistance(dungeon, room, neighbour);
+            if (next < distance[neighbour]) {
+                distance[neighbour] = next;
+                open.emplace(next, neighbour);
+            }
+        }
+    }
+    return distance;
+}
@@ -0,0 +1,154 @@
+#include "check.hpp"
+
+#include "dungeonReference.hpp"
+#include "dungeonRegion.hpp"
+
+#include <set>
+
+using namespace DungeonGenerator;
+
+namespace
+{
+    bool Connected(const Dungeon& dungeon)
+    {
+        std::vector<bool> seen(dungeon.mVertices.size(), false);
+        std::vector<std::uint32_t> stack{ 0 };
+        seen[0] = true;
+        std::size_t reached = 1;
+        while (!stack.empty()) {
+            const std::uint32_t room = stack.back();
+            stack.pop_back();
+            for (std::uint32_t neighbour : dungeon.mVertices[room].mConnections) {
+                if (!seen[neighbour]) {
+                    seen[neighbour] = true;
+                    ++reached;
+                    stack.push_back(neighbour);
+                }
+            }
+        }
+        return reached == dungeon.mVertices.size();
+    }
+
+    // mEdges and the connections describe the same corridors, each once
+    bool EdgesMatchConnections(const Dungeon& dungeon)
+    {
+        std::set<std::pair<std::uint32_t, std::uint32_t>> edges;
+        for (const auto& edge : dungeon.mEdges) {
+            if (edge.mNode1 == edge.mNode2 || !edges.insert(std::minmax(edge.mNode1, edge.mNode2)).second) {
+                return false;
+            }
+        }
+        std::size_t connections = 0;
+        for (std::uint32_t room = 0; room < dungeon.mVertices.size(); room++) {
+            for (std::uint32_t neighbour : dungeon.mVertices[room].mConnections) {
+                connections += edges.contains(std::minmax(room, neighbour));
+            }
+        }
+        return connections == 2 * dungeon.mEdges.size();
+    }
+
+    // Rooms at the border of the map stay on it, for both map shapes
+    void TestClipping()
+    {
+        for (const bool circle : { false, true }) {
+            const GenerationData data(2000, 100, 3, { 1.0f, 2.0f }, { 100.0f, 100.0f }, circle, true, 0.3f);
+            for (const DungeonRegion region : { DungeonRegion{ 0.0f, 50.0f, 20.0f }, DungeonRegion{ 0.0f, 0.0f, 30.0f }, DungeonRegion{ 100.0f, 100.0f, 45.0f } }) {
+                Dungeon dungeon(data);
+                const auto result = RegenerateRegion(dungeon, region, 7);
+                CHECK(!result.mRooms.empty());
+                for (std::uint32_t room : result.mRooms) {
+                    const auto& vertex = dungeon.mVertices[room];
+                    CHECK(region.Contains(vertex.mPx, vertex.mPy));
+                    CHECK(RegionDetail::OnMap(data, vertex.mPx, vertex.mPy));
+                }
+                CHECK(Connected(dungeon));
+                CHECK(EdgesMatchConnections(dungeon));
+            }
+        }
+    }
+
+    // Rooms from a PointSet can lie off the map, a region there keeps its rooms in place and rewires them
+    void TestOffMap()
+    {
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> position(300.0f, 350.0f);
+        std::vector<float> coords(200);
+        for (float& coord : coords) {
+            coord = position(random);
+        }
+        Dungeon dungeon(GenerationData{}, PointSet::Interleaved(coords));
+        const auto result = RegenerateRegion(dungeon, { 320.0f, 320.0f, 8.0f }, 5);
+        CHECK(!result.mRooms.empty());
+        for (std::uint32_t room : result.mRooms) {
+            CHECK(dungeon.mVertices[room].mPx == coords[2 * room] && dungeon.mVertices[room].mPy == coords[2 * room + 1]);
+        }
+        CHECK(Connected(dungeon));
+        CHECK(EdgesMatchConnections(dungeon));
+    }
+
+    // One index kept over many calls gives the same dungeon as a new index per call
+    void TestIndexReuse()
+    {
+        const GenerationData data(3000, 300, 11, { 1.0f, 2.0f }, { 1200.0f, 1200.0f }, false, true, 0.3f);
+        Dungeon kept(data), fresh(data);
+        RegionIndex index(kept);
+        for (int i = 0; i < 40; i++) {
+            const DungeonRegion region{ static_cast<float>(i * 137 % 1200), static_cast<float>(i * 71 % 1200), 40.0f + static_cast<float>(i % 7) * 20.0f };
+            const auto keptResult = RegenerateRegion(kept, index, region, i);
+            const auto freshResult = RegenerateRegion(fresh, region, i);
+            CHECK(keptResult.mRooms == freshResult.mRooms);
+            CHECK(keptResult.mAddedEdges == freshResult.mAddedEdges && keptResult.mRemovedEdges == freshResult.mRemovedEdges);
+        }
+        CHECK(kept.mEdges.size() == fresh.mEdges.size());
+        for (std::size_t i = 0; i < kept.mEdges.size() && i < fresh.mEdges.size(); i++) {
+            CHECK(kept.mEdges[i].mNode1 == fresh.mEdges[i].mNode1 && kept.mEdges[i].mNode2 == fresh.mEdges[i].mNode2);
+        }
+        CHECK(Connected(kept));
+        CHECK(EdgesMatchConnections(kept));
+    }
+
+    // The updated hierarchy and metrics match what a full rebuild computes
+    void TestDerivedData()
+    {
+        GenerationData data(6000, 600, 5, { 1.0f, 2.0f }, { 1700.0f, 1700.0f }, false, true, 0.3f);
+        data.mBuildPathHierarchy = true;
+        data.mComputeMetrics = true;
+        Dungeon dungeon(data);
+        RegionIndex index(dungeon);
+
+        std::mt19937 random(5);
+        for (int i = 0; i < 10; i++) {
+            const DungeonRegion region{ static_cast<float>(random() % 1700), static_cast<float>(random() % 1700), 60.0f + static_cast<float>(random() % 150) };
+            RegenerateRegion(dungeon, index, region, i);
+
+            const DungeonMetrics full = ComputeDungeonMetrics(dungeon);
+            DungeonMetrics updated = dungeon.mMetrics;
+            CHECK(std::abs(updated.mAverageCorridorLength - full.mAverageCorridorLength) < 1e-3f * full.mAverageCorridorLength);
+            updated.mAverageCorridorLength = full.mAverageCorridorLength;
+            CHECK(updated == full);
+
+            const PathHierarchy& hierarchy = dungeon.mPathHierarchy;
+            const std::uint32_t start = random() % hierarchy.RoomCount();
+            const auto exact = Dijkstra(dungeon, start);
+            for (int k = 0; k < 40; k++) {
+                const std::uint32_t goal = random() % hierarchy.RoomCount();
+                const float distance = hierarchy.Distance(start, goal);
+                if (hierarchy.ClusterOf(start) != hierarchy.ClusterOf(goal)) {
+                    CHECK(std::abs(distance - exact[goal]) <= 1e-3f * std::max(1.0f, exact[goal]));
+                }
+                else {
+                    CHECK(distance >= exact[goal] - 1e-3f);
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestClipping();
+    TestOffMap();
+    TestIndexReuse();
+    TestDerivedData();
+    return TestResult();
+}
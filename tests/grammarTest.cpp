@@ -0,0 +1,50 @@
+#include "check.hpp"
+
+#include "grammar.hpp"
+
+namespace
+{
+    using SymbolID = SymbolRegistry::SymbolID;
+
+    SymbolRegistry Registry()
+    {
+        SymbolRegistry registry;
+        for (const char* name : { "S", "a", "b" }) {
+            registry.AddSymbol({ true, name });
+        }
+        return registry;
+    }
+
+    // Rules that all have weight 0 never apply, in either mode
+    void TestZeroWeights()
+    {
+        SymbolRegistry registry = Registry();
+        const Grammar grammar(registry, { { { "S" }, { "a" }, 0.0f } });
+        const std::vector<SymbolID> start{ registry.GetSymbol("S"), registry.GetSymbol("S") };
+        for (const ExecutionMode mode : { ExecutionMode::SEARCH, ExecutionMode::INDEXED }) {
+            ExecutionSettings settings;
+            settings.mode = mode;
+            CHECK(grammar.Expand(start, 1, settings) == start);
+        }
+    }
+
+    // A rule with weight 0 next to one that applies is never picked, even once it is the only one with occurrences
+    void TestZeroWeightBesideOthers()
+    {
+        SymbolRegistry registry = Registry();
+        const Grammar grammar(registry, { { { "S" }, { "a", "b" }, 0.0f }, { { "S" }, { "b" }, 1.0f }, { { "b" }, { "a" }, 0.0f } });
+        const std::vector<SymbolID> start(20, registry.GetSymbol("S"));
+        for (const ExecutionMode mode : { ExecutionMode::SEARCH, ExecutionMode::INDEXED }) {
+            ExecutionSettings settings;
+            settings.mode = mode;
+            CHECK(grammar.Expand(start, 3, settings) == std::vector<SymbolID>(20, registry.GetSymbol("b")));
+        }
+    }
+}
+
+int main()
+{
+    TestZeroWeights();
+    TestZeroWeightBesideOthers();
+    return TestResult();
+}
@@ -0,0 +1,51 @@
+#include "check.hpp"
+
+#include "graph.hpp"
+#include "graph_algorithms.hpp"
+
+namespace
+{
+    using Index = GraphAlgorithms::Index;
+
+    // A path 0-1-2 with a shortcut 0-2 that is heavier than the path, and a separate pair 3-4
+    GraphSnapshot DisconnectedSnapshot()
+    {
+        Graph<int, float> graph;
+        std::vector<VertexId> vertices;
+        for (int i = 0; i < 5; i++) {
+            vertices.push_back(graph.AddVertex(i));
+        }
+        graph.AddEdge(vertices[0], vertices[1], 1.0f);
+        graph.AddEdge(vertices[1], vertices[2], 1.0f);
+        graph.AddEdge(vertices[0], vertices[2], 5.0f);
+        graph.AddEdge(vertices[3], vertices[4], 1.0f);
+        return graph.Snapshot([](float weight) { return weight; });
+    }
+
+    // Paths into the other component are empty, not just the target
+    void TestExtractPath()
+    {
+        const GraphSnapshot snapshot = DisconnectedSnapshot();
+
+        const auto breadthFirst = GraphAlgorithms::BreadthFirst(snapshot, 0);
+        CHECK(GraphAlgorithms::ExtractPath(breadthFirst.parent, 0, 2) == std::vector<Index>({ 0, 2 }));
+        CHECK(GraphAlgorithms::ExtractPath(breadthFirst.parent, 0, 0) == std::vector<Index>({ 0 }));
+        CHECK(GraphAlgorithms::ExtractPath(breadthFirst.parent, 0, 3).empty());
+        CHECK(GraphAlgorithms::ExtractPath(breadthFirst.parent, 0, 4).empty());
+        CHECK(GraphAlgorithms::ExtractPath(breadthFirst.parent, 0, 5).empty());
+
+        const auto shortest = GraphAlgorithms::Dijkstra(snapshot, 0);
+        CHECK(GraphAlgorithms::ExtractPath(shortest.parent, 0, 2) == std::vector<Index>({ 0, 1, 2 }));
+        CHECK(GraphAlgorithms::ExtractPath(shortest.parent, 0, 4).empty());
+
+        const auto fromOther = GraphAlgorithms::Dijkstra(snapshot, 4);
+        CHECK(GraphAlgorithms::ExtractPath(fromOther.parent, 4, 3) == std::vector<Index>({ 4, 3 }));
+        CHECK(GraphAlgorithms::ExtractPath(fromOther.parent, 4, 0).empty());
+    }
+}
+
+int main()
+{
+    TestExtractPath();
+    return TestResult();
+}
@@ -0,0 +1,182 @@
+#include "check.hpp"
+
+#include "graph_rewriter.hpp"
+
+#include <set>
+
+namespace
+{
+    using LabelGraph = GraphRewriter::LabelGraph;
+    using SymbolID = SymbolRegistry::SymbolID;
+
+    // Counts the matches of one rule by trying every injective mapping of its lhs nodes
+    size_t CountMatches(const SymbolRegistry& registry, const GraphRule& rule, const LabelGraph& graph)
+    {
+        std::vector<VertexId> vertices;
+        for (const auto& vertex : graph.VertexData()) {
+            vertices.push_back(vertex.first);
+        }
+
+        // (dense index, dense index, label) of every edge, both directions
+        std::set<std::tuple<size_t, size_t, SymbolID>> edges;
+        for (const auto& edge : graph.EdgeData()) {
+            const size_t a = graph.VertexData().DenseIndex(edge.second._v1);
+            const size_t b = graph.VertexData().DenseIndex(edge.second._v2);
+            edges.emplace(a, b, edge.second._data);
+            edges.emplace(b, a, edge.second._data);
+        }
+        const auto& hasEdge = [&](size_t a, size_t b, const std::string& label) {
+            if (!label.empty()) {
+                return edges.contains({ a, b, registry.GetSymbol(label) });
+            }
+            const auto it = edges.lower_bound({ a, b, 0 });
+            return it != edges.end() && std::get<0>(*it) == a && std::get<1>(*it) == b;
+        };
+
+        size_t count = 0;
+        std::vector<size_t> binding(rule.lhsNodes.size());
+        const auto& extend = [&](const auto& self, size_t node) -> void {
+            if (node == rule.lhsNodes.size()) {
+                for (const auto& edge : rule.lhsEdges) {
+                    if (!hasEdge(binding[edge.from], binding[edge.to], edge.label)) {
+                        return;
+                    }
+                }
+                ++count;
+                return;
+            }
+            for (size_t v = 0; v < vertices.size(); v++) {
+                if (graph.GetVertex(vertices[v])._data != registry.GetSymbol(rule.lhsNodes[node])
+                    || std::find(binding.begin(), binding.begin() + static_cast<std::ptrdiff_t>(node), v) != binding.begin() + static_cast<std::ptrdiff_t>(node)) {
+                    continue;
+                }
+                binding[node] = v;
+                self(self, node + 1);
+            }
+        };
+        extend(extend, 0);
+        return count;
+    }
+
+    SymbolRegistry Registry()
+    {
+        SymbolRegistry registry;
+        for (const char* name : { "room", "key", "lock", "boss", "corridor", "door" }) {
+            registry.AddSymbol({ true, name });
+        }
+        return registry;
+    }
+
+    std::vector<GraphRule> Rules()
+    {
+        return {
+            // A corridor becomes a locked door with its key in between
+            { { "room", "room" }, { { 0, 1, "corridor" } }, { "room", "key", "lock", "room" },
+                { { 0, 1, "door" }, { 1, 2, "door" }, { 2, 3, "door" } }, { { 0, 0 }, { 1, 3 } }, 1.0f },
+            // A triangle of rooms, any edge labels, gets a boss
+            { { "room", "room", "room" }, { { 0, 1 }, { 1, 2 }, { 2, 0 } }, { "boss", "room", "room" },
+                { { 0, 1, "corridor" }, { 1, 2, "corridor" }, { 2, 0, "corridor" } }, { { 0, 0 }, { 1, 1 }, { 2, 2 } }, 2.0f },
+            // A key behind its lock turns back into a corridor
+            { { "key", "lock" }, { { 0, 1, "door" } }, { "room", "room" }, { { 0, 1, "corridor" } }, { { 0, 0 }, { 1, 1 } }, 0.5f },
+            // A boss next to a room drops out, the room stays
+            { { "boss", "room" }, { { 0, 1 } }, { "room" }, {}, { { 1, 0 } }, 0.5f },
+        };
+    }
+
+    // Rooms on a path with some chords, so every rule has matches
+    LabelGraph StartGraph(const SymbolRegistry& registry, int rooms)
+    {
+        LabelGraph graph;
+        const SymbolID room = registry.GetSymbol("room"), corridor = registry.GetSymbol("corridor");
+        std::vector<VertexId> vertices;
+        for (int i = 0; i < rooms; i++) {
+            vertices.push_back(graph.AddVertex(room));
+        }
+        for (int i = 0; i + 1 < rooms; i++) {
+            graph.AddEdge(vertices[i], vertices[i + 1], corridor);
+        }
+        for (int i = 0; i + 2 < rooms; i += 3) {
+            graph.AddEdge(vertices[i], vertices[i + 2], corridor);
+        }
+        return graph;
+    }
+
+    // After every single rewrite the kept matches are exactly the matches of the rewritten graph
+    void TestMatchesAfterEachRewrite()
+    {
+        SymbolRegistry registry = Registry();
+        const auto rules = Rules();
+        GraphRewriter rewriter(registry, rules);
+        rewriter.SetGraph(StartGraph(registry, 16));
+
+        for (uint32_t rule = 0; rule < rules.size(); rule++) {
+            CHECK(rewriter.MatchCount(rule) == CountMatches(registry, rules[rule], rewriter.GetGraph()));
+        }
+        CHECK(rewriter.MatchCount(0) > 0 && rewriter.MatchCount(1) > 0);
+
+        ExecutionSettings settings;
+        settings.maxSteps = 1;
+        uint32_t applied = 0;
+        for (uint64_t step = 0; step < 60; step++) {
+            settings.seed = step;
+            applied += rewriter.Execute(settings);
+            size_t total = 0;
+            for (uint32_t rule = 0; rule < rules.size(); rule++) {
+                CHECK(rewriter.MatchCount(rule) == CountMatches(registry, rules[rule], rewriter.GetGraph()));
+                total += rewriter.MatchCount(rule);
+            }
+            CHECK(rewriter.MatchCount() == total);
+        }
+        CHECK(applied > 0);
+    }
+
+    // Many rewrites on a larger graph keep the same matches as a rewriter that starts from the result
+    void TestAgainstFreshRewriter()
+    {
+        SymbolRegistry registry = Registry();
+        const auto rules = Rules();
+        GraphRewriter rewriter(registry, rules);
+        rewriter.SetGraph(StartGraph(registry, 2000));
+
+        ExecutionSettings settings;
+        settings.maxSteps = 3000;
+        for (uint64_t round = 0; round < 4; round++) {
+            settings.seed = round;
+            rewriter.Execute(settings);
+
+            GraphRewriter fresh(registry, rules);
+            fresh.SetGraph(rewriter.GetGraph());
+            for (uint32_t rule = 0; rule < rules.size(); rule++) {
+                CHECK(rewriter.MatchCount(rule) == fresh.MatchCount(rule));
+            }
+        }
+    }
+
+    // The same seed rewrites the same graph the same way
+    void TestSeeded()
+    {
+        SymbolRegistry registry = Registry();
+        const auto rules = Rules();
+        GraphRewriter a(registry, rules), b(registry, rules);
+        a.SetGraph(StartGraph(registry, 200));
+        b.SetGraph(StartGraph(registry, 200));
+
+        ExecutionSettings settings;
+        settings.seed = 42;
+        settings.maxSteps = 150;
+        CHECK(a.Execute(settings) == b.Execute(settings));
+        CHECK(a.GetGraph().VertexCount() == b.GetGraph().VertexCount());
+        CHECK(a.GetGraph().EdgeCount() == b.GetGraph().EdgeCount());
+        for (uint32_t rule = 0; rule < rules.size(); rule++) {
+            CHECK(a.MatchCount(rule) == b.MatchCount(rule));
+        }
+    }
+}
+
+int main()
+{
+    TestMatchesAfterEachRewrite();
+    TestAgainstFreshRewriter();
+    TestSeeded();
+    return TestResult();
+}
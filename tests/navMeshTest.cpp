@@ -0,0 +1,141 @@
+#include "check.hpp"
+
+#include "dungeonerator.hpp"
+
+#include <map>
+
+using namespace DungeonGenerator;
+
+namespace
+{
+    float Length(const std::vector<NavMesh::Point>& path)
+    {
+        float length = 0.0f;
+        for (std::size_t i = 1; i < path.size(); i++) {
+            length += std::hypot(path[i].mX - path[i - 1].mX, path[i].mY - path[i - 1].mY);
+        }
+        return length;
+    }
+
+    // size x size unit squares of two triangles each, walkable where the predicate holds.
+    // The generator produces clockwise triangles, the funnel must not depend on it.
+    template<typename Walkable>
+    NavMesh GridMesh(std::uint32_t size, bool clockwise, Walkable&& walkable)
+    {
+        std::vector<float> coords;
+        for (std::uint32_t y = 0; y <= size; y++) {
+            for (std::uint32_t x = 0; x <= size; x++) {
+                coords.push_back(static_cast<float>(x));
+                coords.push_back(static_cast<float>(y));
+            }
+        }
+
+        std::vector<std::size_t> triangles;
+        std::vector<bool> cellWalkable;
+        for (std::uint32_t y = 0; y < size; y++) {
+            for (std::uint32_t x = 0; x < size; x++) {
+                const std::size_t p00 = y * (size + 1) + x, p10 = p00 + 1, p01 = p00 + size + 1, p11 = p01 + 1;
+                if (clockwise) {
+                    triangles.insert(triangles.end(), { p00, p01, p11, p00, p11, p10 });
+                } else {
+                    triangles.insert(triangles.end(), { p00, p11, p01, p00, p10, p11 });
+                }
+                cellWalkable.push_back(walkable(x, y));
+                cellWalkable.push_back(walkable(x, y));
+            }
+        }
+
+        std::vector<std::size_t> halfEdges(triangles.size(), std::numeric_limits<std::size_t>::max());
+        std::map<std::pair<std::size_t, std::size_t>, std::size_t> open;
+        for (std::size_t e = 0; e < triangles.size(); e++) {
+            const std::size_t a = triangles[e], b = triangles[e % 3 == 2 ? e - 2 : e + 1];
+            if (const auto twin = open.find({ b, a }); twin != open.end()) {
+                halfEdges[e] = twin->second;
+                halfEdges[twin->second] = e;
+                open.erase(twin);
+            } else {
+                open[{ a, b }] = e;
+            }
+        }
+
+        const std::vector<float> roomSizes(coords.size() / 2, 0.0f);
+        NavMesh mesh(coords, triangles, halfEdges, std::vector<bool>(triangles.size(), false), roomSizes);
+        for (std::uint32_t t = 0; t < mesh.TriangleCount(); t++) {
+            mesh.mFlags[t] = cellWalkable[t] ? NavMesh::ROOM : NavMesh::WALL;
+        }
+        return mesh;
+    }
+
+    // With every triangle walkable the mesh is convex, so every path is the straight line
+    void TestStraightLine()
+    {
+        for (int seed = 1; seed <= 3; seed++) {
+            GenerationData data(2000, 50, seed, { 1.0f, 3.0f }, { 200.0f, 200.0f }, seed == 2, true, 0.3f);
+            data.mBuildNavMesh = true;
+            Dungeon dungeon(data);
+            NavMesh mesh = dungeon.mNavMesh;
+            CHECK(!mesh.Empty());
+            std::fill(mesh.mFlags.begin(), mesh.mFlags.end(), NavMesh::ROOM);
+
+            std::mt19937 random(seed);
+            for (int i = 0; i < 200; i++) {
+                const NavMesh::Point from = mesh.Centroid(random() % mesh.TriangleCount());
+                const NavMesh::Point to = mesh.Centroid(random() % mesh.TriangleCount());
+                const auto path = mesh.FindPath(from, to);
+                CHECK(!path.empty() && path.front() == from && path.back() == to);
+                CHECK(path.size() == (from == to ? 1u : 2u));
+            }
+        }
+    }
+
+    // A corridor along the bottom row and up the right column bends once around the inner corner
+    void TestBend(bool clockwise)
+    {
+        const NavMesh mesh = GridMesh(3, clockwise, [](std::uint32_t x, std::uint32_t y) { return y == 0 || x == 2; });
+        const NavMesh::Point from{ 0.5f, 0.5f }, to{ 2.5f, 2.5f };
+        const auto path = mesh.FindPath(from, to);
+        CHECK(path.size() == 3);
+        if (path.size() == 3) {
+            CHECK(path[0] == from);
+            CHECK(path[1] == (NavMesh::Point{ 2.0f, 1.0f }));
+            CHECK(path[2] == to);
+        }
+
+        // The other way around the same corner
+        const auto back = mesh.FindPath(to, from);
+        CHECK(back.size() == 3 && back[1] == (NavMesh::Point{ 2.0f, 1.0f }));
+        CHECK(std::abs(Length(path) - Length(back)) < 1e-4f);
+
+        // Inside the bottom row the path stays straight
+        const auto straight = mesh.FindPath(from, { 2.5f, 0.25f });
+        CHECK(straight.size() == 2);
+
+        // The walls are not crossed, the top left cell cannot be reached
+        CHECK(mesh.FindPath(from, { 0.5f, 2.5f }).empty());
+    }
+
+    // Corridors that do not walk from neighbour to neighbour give no path
+    void TestInvalidCorridor()
+    {
+        const NavMesh mesh = GridMesh(3, true, [](std::uint32_t, std::uint32_t) { return true; });
+        const NavMesh::Point from = mesh.Centroid(0), to = mesh.Centroid(mesh.TriangleCount() - 1);
+        const std::uint32_t start = mesh.Locate(from), goal = mesh.Locate(to);
+        const auto corridor = mesh.FindTrianglePath(start, goal);
+        CHECK(mesh.Funnel(corridor, from, to).size() >= 2);
+
+        const std::vector<std::uint32_t> skipped{ start, goal };
+        CHECK(mesh.Funnel(skipped, from, to).empty());
+        const std::vector<std::uint32_t> outside{ mesh.TriangleCount(), start };
+        CHECK(mesh.Funnel(outside, from, to).empty());
+        CHECK(mesh.Funnel({}, from, to).empty());
+    }
+}
+
+int main()
+{
+    TestStraightLine();
+    TestBend(true);
+    TestBend(false);
+    TestInvalidCorridor();
+    return TestResult();
+}
@@ -0,0 +1,152 @@
+#include "check.hpp"
+
+#include "occurrence_index.hpp"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace
+{
+    using SymbolID = OccurrenceIndex::SymbolID;
+
+    // Every position where pattern starts in string, overlapping ones included
+    std::vector<size_t> Positions(const std::vector<SymbolID>& string, const std::vector<SymbolID>& pattern)
+    {
+        std::vector<size_t> positions;
+        for (size_t p = 0; p + pattern.size() <= string.size(); p++) {
+            if (std::equal(pattern.begin(), pattern.end(), string.begin() + static_cast<std::ptrdiff_t>(p))) {
+                positions.push_back(p);
+            }
+        }
+        return positions;
+    }
+
+    // The index holds exactly the occurrences a search of the string finds, each once
+    void CheckOccurrences(const OccurrenceIndex& index, const std::vector<std::vector<SymbolID>>& patterns, const std::vector<SymbolID>& string)
+    {
+        std::set<uint32_t> active;
+        for (uint32_t rule = 0; rule < patterns.size(); rule++) {
+            const size_t expected = Positions(string, patterns[rule]).size();
+            CHECK(index.OccurrenceCount(rule) == expected);
+            if (expected > 0) {
+                active.insert(rule);
+            }
+
+            std::set<OccurrenceIndex::NodeId> starts;
+            for (size_t i = 0; i < index.OccurrenceCount(rule); i++) {
+                const auto match = index.GetOccurrence(rule, i);
+                CHECK(match.rule == rule);
+                starts.insert(match.start);
+            }
+            CHECK(starts.size() == index.OccurrenceCount(rule));
+        }
+        CHECK(std::set<uint32_t>(index.ActiveRules().begin(), index.ActiveRules().end()) == active);
+        CHECK(index.ActiveRules().size() == active.size());
+    }
+
+    // Random rules over a small alphabet, so occurrences overlap, border each other and appear through rewrites
+    void TestRandomRewrites()
+    {
+        std::mt19937 random(1);
+        for (int trial = 0; trial < 200; trial++) {
+            const uint32_t alphabet = 2 + random() % 3;
+            std::vector<std::vector<SymbolID>> lhs(1 + random() % 5), rhs(lhs.size());
+            for (size_t rule = 0; rule < lhs.size(); rule++) {
+                for (uint32_t i = 0, length = 1 + random() % 3; i < length; i++) {
+                    lhs[rule].push_back(random() % alphabet);
+                }
+                // One symbol more than the lhs use, so rewrites can also create symbols no rule contains
+                for (uint32_t i = 0, length = random() % 4; i < length; i++) {
+                    rhs[rule].push_back(random() % (alphabet + 1));
+                }
+            }
+
+            const RuleMatcher matcher(lhs);
+            OccurrenceIndex index(matcher);
+            std::vector<SymbolID> string;
+            for (uint32_t i = 0, length = random() % 20; i < length; i++) {
+                string.push_back(random() % (alphabet + 1));
+            }
+            index.Assign(string);
+
+            std::vector<SymbolID> current;
+            for (int step = 0; step < 100; step++) {
+                index.CopyTo(current);
+                CHECK(current == string);
+                CHECK(index.Size() == string.size());
+                CheckOccurrences(index, lhs, string);
+                if (index.ActiveRules().empty()) {
+                    break;
+                }
+
+                const uint32_t rule = index.ActiveRules()[random() % index.ActiveRules().size()];
+                index.Apply(index.GetOccurrence(rule, random() % index.OccurrenceCount(rule)), rhs[rule]);
+
+                // The result is the string with one of the occurrences replaced
+                index.CopyTo(current);
+                bool replaced = false;
+                for (size_t p : Positions(string, lhs[rule])) {
+                    std::vector<SymbolID> expected(string.begin(), string.begin() + static_cast<std::ptrdiff_t>(p));
+                    expected.insert(expected.end(), rhs[rule].begin(), rhs[rule].end());
+                    expected.insert(expected.end(), string.begin() + static_cast<std::ptrdiff_t>(p + lhs[rule].size()), string.end());
+                    replaced = replaced || expected == current;
+                }
+                CHECK(replaced);
+                string = current;
+            }
+        }
+    }
+
+    // A long run of growing and shrinking rewrites reuses freed nodes, a fresh index on the result agrees
+    void TestAgainstFreshIndex()
+    {
+        const std::vector<std::vector<SymbolID>> lhs{ { 1 }, { 2, 3 }, { 3, 1 }, { 1, 1, 2 } };
+        const std::vector<std::vector<SymbolID>> rhs{ { 2, 3 }, { 3, 1, 4 }, { 1, 1, 2 }, { 1 } };
+        const RuleMatcher matcher(lhs);
+        OccurrenceIndex index(matcher);
+        index.Assign(std::vector<SymbolID>(500, 1));
+
+        std::mt19937 random(7);
+        std::vector<SymbolID> string;
+        for (int round = 0; round < 5; round++) {
+            for (int step = 0; step < 2000 && !index.ActiveRules().empty(); step++) {
+                const uint32_t rule = index.ActiveRules()[random() % index.ActiveRules().size()];
+                index.Apply(index.GetOccurrence(rule, random() % index.OccurrenceCount(rule)), rhs[rule]);
+            }
+
+            index.CopyTo(string);
+            OccurrenceIndex fresh(matcher);
+            fresh.Assign(string);
+            for (uint32_t rule = 0; rule < lhs.size(); rule++) {
+                CHECK(index.OccurrenceCount(rule) == fresh.OccurrenceCount(rule));
+            }
+            CheckOccurrences(index, lhs, string);
+        }
+    }
+
+    // Assign replaces the whole string and drops the old occurrences
+    void TestReassign()
+    {
+        const std::vector<std::vector<SymbolID>> lhs{ { 0, 0 }, { 1 } };
+        const RuleMatcher matcher(lhs);
+        OccurrenceIndex index(matcher);
+        index.Assign(std::vector<SymbolID>{ 0, 0, 0, 1 });
+        CHECK(index.OccurrenceCount(0) == 2 && index.OccurrenceCount(1) == 1);
+
+        index.Assign(std::vector<SymbolID>{ 1, 1 });
+        CHECK(index.OccurrenceCount(0) == 0 && index.OccurrenceCount(1) == 2);
+        CHECK(index.ActiveRules().size() == 1 && index.ActiveRules()[0] == 1);
+
+        index.Assign({});
+        CHECK(index.Size() == 0 && index.ActiveRules().empty());
+    }
+}
+
+int main()
+{
+    TestRandomRewrites();
+    TestAgainstFreshIndex();
+    TestReassign();
+    return TestResult();
+}
@@ -0,0 +1,102 @@
+#include "check.hpp"
+
+#include "dungeonReference.hpp"
+#include "dungeonerator.hpp"
+
+using namespace DungeonGenerator;
+
+namespace
+{
+    bool Near(float a, float b)
+    {
+        return std::abs(a - b) <= 1e-3f * std::max(1.0f, std::abs(b));
+    }
+
+    // Between clusters the portal graph holds the exact distances, within a cluster the local path can be longer
+    void TestAgainstDijkstra(int seed, std::uint32_t rooms, int loops)
+    {
+        GenerationData data(rooms, loops, seed);
+        data.mSizeX = data.mSizeY = 20.0f * std::sqrt(static_cast<float>(rooms));
+        data.mBuildPathHierarchy = true;
+        const Dungeon dungeon(data);
+        const PathHierarchy& hierarchy = dungeon.mPathHierarchy;
+        CHECK(hierarchy.RoomCount() == dungeon.mVertices.size());
+        CHECK(hierarchy.ClusterCount() > 1);
+
+        std::mt19937 random(seed);
+        for (int source = 0; source < 8; source++) {
+            const std::uint32_t start = random() % hierarchy.RoomCount();
+            const auto exact = Dijkstra(dungeon, start);
+            for (int i = 0; i < 50; i++) {
+                const std::uint32_t goal = random() % hierarchy.RoomCount();
+                const float distance = hierarchy.Distance(start, goal);
+                if (hierarchy.ClusterOf(start) != hierarchy.ClusterOf(goal)) {
+                    CHECK(Near(distance, exact[goal]));
+                }
+                else {
+                    CHECK(distance >= exact[goal] - 1e-3f);
+                }
+
+                // The refined path walks existing corridors and has the reported length
+                const auto path = hierarchy.FindPath(start, goal);
+                CHECK(Near(path.mLength, distance));
+                CHECK(!path.mRooms.empty() && path.mRooms.front() == start && path.mRooms.back() == goal);
+                float length = 0.0f;
+                for (std::size_t k = 1; k < path.mRooms.size(); k++) {
+                    const auto& connections = dungeon.mVertices[path.mRooms[k - 1]].mConnections;
+                    CHECK(std::find(connections.begin(), connections.end(), path.mRooms[k]) != connections.end());
+                    length += RoomDistance(dungeon, path.mRooms[k - 1], path.mRooms[k]);
+                }
+                CHECK(Near(length, path.mLength));
+            }
+        }
+    }
+
+    // Queries within one cluster reuse the scratch of the portal search, alternating both must not mix them up
+    void TestAlternatingQueries()
+    {
+        GenerationData data(3000, 100, 5);
+        data.mSizeX = data.mSizeY = 1000.0f;
+        data.mBuildPathHierarchy = true;
+        const Dungeon dungeon(data);
+        const PathHierarchy& hierarchy = dungeon.mPathHierarchy;
+
+        const std::uint32_t start = 0;
+        const auto exact = Dijkstra(dungeon, start);
+        const auto sameCluster = hierarchy.ClusterRooms(hierarchy.ClusterOf(start));
+        for (std::uint32_t goal = 0; goal < hierarchy.RoomCount(); goal += 7) {
+            (void)hierarchy.Distance(start, sameCluster[goal % sameCluster.size()]);
+            if (hierarchy.ClusterOf(goal) != hierarchy.ClusterOf(start)) {
+                CHECK(Near(hierarchy.Distance(start, goal), exact[goal]));
+            }
+        }
+    }
+
+    void TestThreadCount()
+    {
+        GenerationData data(4000, 200, 9);
+        data.mSizeX = data.mSizeY = 1200.0f;
+        const Dungeon dungeon(data);
+        std::vector<float> positions;
+        for (const auto& vertex : dungeon.mVertices) {
+            positions.push_back(vertex.mPx);
+            positions.push_back(vertex.mPy);
+        }
+        const RoomGraph graph(dungeon.mVertices.size(), dungeon.mEdges);
+        const PathHierarchy single(positions, graph, 0.0f, 1);
+        const PathHierarchy several(positions, graph, 0.0f, 4);
+        for (std::uint32_t room = 0; room < single.RoomCount(); room += 13) {
+            CHECK(single.Distance(0, room) == several.Distance(0, room));
+        }
+    }
+}
+
+int main()
+{
+    TestAgainstDijkstra(1, 2000, 50);
+    TestAgainstDijkstra(2, 5000, 500);
+    TestAgainstDijkstra(3, 500, 0);
+    TestAlternatingQueries();
+    TestThreadCount();
+    return TestResult();
+}